@@ -0,0 +1,82 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "main.h"
+
+AmxString::AmxString(const cell *addr) {
+  thread_local std::array<std::string, kBufferCount> buffers;
+  thread_local std::size_t next_buffer{};
+
+  auto &buffer = buffers[next_buffer];
+
+  next_buffer = (next_buffer + 1) % kBufferCount;
+
+  buffer.clear();
+
+  if (static_cast<ucell>(*addr) > UNPACKEDMAX) {
+    for (std::size_t i{};; ++i) {
+      const auto ch = static_cast<char>(
+          static_cast<ucell>(addr[i / sizeof(cell)]) >>
+          ((sizeof(cell) - 1 - i % sizeof(cell)) * 8));
+      if (!ch) {
+        break;
+      }
+
+      buffer.push_back(ch);
+    }
+  } else {
+    for (auto p = addr; *p; ++p) {
+      buffer.push_back(static_cast<char>(*p));
+    }
+  }
+
+  data_ = buffer.c_str();
+  size_ = buffer.size();
+}
+
+void SetAmxString(cell *dest, std::string_view src, cell size) {
+  if (size <= 0) {
+    return;
+  }
+
+  const auto length =
+      std::min(src.size(), static_cast<std::size_t>(size - 1));
+
+  for (std::size_t i{}; i < length; ++i) {
+    dest[i] = static_cast<unsigned char>(src[i]);
+  }
+
+  dest[length] = 0;
+}
+
+cell *GetAmxArrayRow(cell *array, std::size_t row) {
+  if (array[0] <= 0 ||
+      row >= static_cast<std::size_t>(array[0]) / sizeof(cell)) {
+    throw std::out_of_range{"Invalid array row"};
+  }
+
+  const auto table = reinterpret_cast<unsigned char *>(array + row);
+
+  return reinterpret_cast<cell *>(table + array[row]);
+}
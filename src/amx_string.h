@@ -0,0 +1,127 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PAWNREGEX_AMX_STRING_H_
+#define PAWNREGEX_AMX_STRING_H_
+
+// Pawn string argument read into a reusable thread-local buffer. Only valid
+// during the native call that produced it.
+class AmxString {
+ public:
+  explicit AmxString(const cell *addr);
+
+  const char *begin() const { return data_; }
+
+  const char *end() const { return data_ + size_; }
+
+  const char *c_str() const { return data_; }
+
+  std::size_t size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+  std::string_view view() const { return {data_, size_}; }
+
+ private:
+  static constexpr std::size_t kBufferCount = 4;
+
+  const char *data_{};
+  std::size_t size_{};
+};
+
+// Output iterator into AMX cells. Characters past size - 1 are counted but
+// not stored.
+class AmxStringWriter {
+ public:
+  class Iterator {
+   public:
+    using iterator_category = std::output_iterator_tag;
+    using value_type = void;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = void;
+
+    explicit Iterator(AmxStringWriter *writer) : writer_{writer} {}
+
+    Iterator &operator=(char ch) {
+      writer_->Put(ch);
+
+      return *this;
+    }
+
+    Iterator &operator*() { return *this; }
+
+    Iterator &operator++() { return *this; }
+
+    Iterator &operator++(int) { return *this; }
+
+   private:
+    AmxStringWriter *writer_;
+  };
+
+  AmxStringWriter(cell *dest, cell size)
+      : dest_{dest}, capacity_{size > 0 ? static_cast<std::size_t>(size - 1)
+                                        : 0},
+        terminate_{size > 0} {}
+
+  Iterator begin() { return Iterator{this}; }
+
+  void Put(char ch) {
+    if (length_ < capacity_) {
+      dest_[length_] = static_cast<unsigned char>(ch);
+    }
+
+    ++length_;
+  }
+
+  // Writes the terminator after the stored characters
+  void Finish() {
+    if (terminate_) {
+      dest_[std::min(length_, capacity_)] = 0;
+    }
+  }
+
+  // Drops everything written so far
+  void Clear() { length_ = 0; }
+
+  // Length of the whole string, including the characters that did not fit
+  std::size_t GetLength() const { return length_; }
+
+  bool IsTruncated() const { return length_ > capacity_; }
+
+ private:
+  cell *dest_;
+  std::size_t capacity_;
+  std::size_t length_{};
+  bool terminate_;
+};
+
+// Writes src into dest, truncated to size - 1 characters
+void SetAmxString(cell *dest, std::string_view src, cell size);
+
+// Returns a row of a 2D Pawn array. The offset table at its start bounds the
+// rows, a row past it throws std::out_of_range.
+cell *GetAmxArrayRow(cell *array, std::size_t row);
+
+#endif  // PAWNREGEX_AMX_STRING_H_
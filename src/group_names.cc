@@ -0,0 +1,135 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "main.h"
+
+GroupNames::GroupNames(std::string_view pattern,
+                       std::regex_constants::syntax_option_type option)
+    : source_{pattern} {
+  constexpr auto kOtherGrammars =
+      std::regex_constants::basic | std::regex_constants::extended |
+      std::regex_constants::awk | std::regex_constants::grep |
+      std::regex_constants::egrep;
+
+  if ((option & kOtherGrammars) ||
+      (source_.find("(?<") == std::string::npos &&
+       source_.find("\\k<") == std::string::npos)) {
+    pattern_ = source_;
+
+    return;
+  }
+
+  Parse(nullptr);
+
+  Parse(&pattern_);
+}
+
+void GroupNames::Parse(std::string *out) {
+  std::size_t group_count{};
+  bool in_class{};
+
+  const auto emit = [out](std::string_view text) {
+    if (out) {
+      out->append(text);
+    }
+  };
+
+  for (std::size_t i{}; i < source_.size(); ++i) {
+    const auto ch = source_[i];
+
+    if (ch == '\\') {
+      if (!in_class && source_.compare(i, 3, "\\k<") == 0) {
+        i += 3;
+
+        const auto name = ReadName(i);
+
+        if (out) {
+          const auto index = Find(name);
+          if (index < 0) {
+            throw std::runtime_error{"Unknown group name " +
+                                     std::string{name}};
+          }
+
+          // Keeps a following digit from joining the group number
+          emit("(?:\\" + std::to_string(index) + ")");
+        }
+
+        continue;
+      }
+
+      emit(std::string_view{source_}.substr(i, 2));
+
+      ++i;
+
+      continue;
+    }
+
+    if (in_class) {
+      in_class = ch != ']';
+    } else if (ch == '[') {
+      in_class = true;
+    } else if (ch == '(') {
+      if (source_.compare(i, 3, "(?<") == 0 && i + 3 < source_.size() &&
+          source_[i + 3] != '=' && source_[i + 3] != '!') {
+        i += 3;
+
+        const auto name = ReadName(i);
+
+        ++group_count;
+
+        if (!out && !indices_.emplace(name, group_count).second) {
+          throw std::runtime_error{"Duplicate group name " +
+                                   std::string{name}};
+        }
+
+        emit("(");
+
+        continue;
+      }
+
+      if (source_.compare(i, 2, "(?") != 0) {
+        ++group_count;
+      }
+    }
+
+    emit(std::string_view{source_}.substr(i, 1));
+  }
+}
+
+std::string_view GroupNames::ReadName(std::size_t &i) const {
+  const auto first = i;
+
+  while (i < source_.size() &&
+         (std::isalnum(static_cast<unsigned char>(source_[i])) ||
+          source_[i] == '_')) {
+    ++i;
+  }
+
+  if (i == first || i >= source_.size() || source_[i] != '>' ||
+      std::isdigit(static_cast<unsigned char>(source_[first]))) {
+    throw std::runtime_error{"Invalid group name in pattern " + source_};
+  }
+
+  return std::string_view{source_}.substr(first, i - first);
+}
@@ -0,0 +1,67 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PAWNREGEX_GROUP_NAMES_H_
+#define PAWNREGEX_GROUP_NAMES_H_
+
+// Named capture groups. std::regex has none, so "(?<name>" and "\k<name>" are
+// rewritten to numbered ones before the pattern is compiled.
+class GroupNames {
+ public:
+  GroupNames(std::string_view pattern,
+             std::regex_constants::syntax_option_type option);
+
+  GroupNames(const GroupNames &) = delete;
+
+  GroupNames &operator=(const GroupNames &) = delete;
+
+  // Pattern to hand to the engine
+  const std::string &GetPattern() const { return pattern_; }
+
+  bool IsEmpty() const { return indices_.empty(); }
+
+  // Returns -1 if there is no group with this name
+  int Find(std::string_view name) const {
+    const auto iter = indices_.find(name);
+
+    return iter == indices_.end() ? -1 : static_cast<int>(iter->second);
+  }
+
+ private:
+  // Walks the pattern, collecting the names when out is nullptr and writing
+  // the rewritten pattern to out otherwise
+  void Parse(std::string *out);
+
+  std::string_view ReadName(std::size_t &i) const;
+
+  std::string source_;
+  std::string pattern_;
+
+  // Keys point into source_
+  std::unordered_map<std::string_view, std::size_t> indices_;
+};
+
+using GroupNamesPtr = std::shared_ptr<const GroupNames>;
+
+#endif  // PAWNREGEX_GROUP_NAMES_H_
@@ -0,0 +1,154 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PAWNREGEX_HANDLE_TABLE_H_
+#define PAWNREGEX_HANDLE_TABLE_H_
+
+// Maps script handles to objects. A handle carries the generation of its
+// slot, so it stays invalid after the slot is reused.
+template <typename T>
+class HandleTable {
+ public:
+  cell Add(T value) {
+    std::size_t index{};
+
+    // Freed slots wait in a queue, so a slot comes back with the same
+    // generation only after kMinFreeSlots << kGenerationBits removals
+    if (free_slots_.size() < kMinFreeSlots && slots_.size() < kMaxSlots) {
+      index = slots_.size();
+
+      slots_.emplace_back();
+    } else if (!free_slots_.empty()) {
+      index = free_slots_.front();
+
+      free_slots_.pop_front();
+    } else {
+      throw std::runtime_error{"Handle table is full"};
+    }
+
+    auto &slot = slots_[index];
+
+    slot.value = std::move(value);
+    slot.used = true;
+
+    ++size_;
+
+    return MakeHandle(index, slot.generation);
+  }
+
+  T *Find(cell handle) {
+    const auto slot = FindSlot(handle);
+
+    return slot ? &slot->value : nullptr;
+  }
+
+  T Remove(cell handle) {
+    const auto slot = FindSlot(handle);
+    if (!slot) {
+      return T{};
+    }
+
+    T value = std::move(slot->value);
+
+    slot->value = T{};
+    slot->used = false;
+    slot->generation = (slot->generation + 1) & kGenerationMask;
+
+    free_slots_.push_back(static_cast<std::uint32_t>(slot - slots_.data()));
+
+    --size_;
+
+    return value;
+  }
+
+  template <typename Func>
+  void Clear(Func on_remove) {
+    for (std::size_t index{}; index < slots_.size(); ++index) {
+      auto &slot = slots_[index];
+      if (!slot.used) {
+        continue;
+      }
+
+      on_remove(std::move(slot.value));
+
+      slot.value = T{};
+      slot.used = false;
+      slot.generation = (slot.generation + 1) & kGenerationMask;
+
+      free_slots_.push_back(static_cast<std::uint32_t>(index));
+    }
+
+    size_ = 0;
+  }
+
+  template <typename Func>
+  void ForEach(Func func) {
+    for (auto &slot : slots_) {
+      if (slot.used) {
+        func(slot.value);
+      }
+    }
+  }
+
+  std::size_t Size() const { return size_; }
+
+ private:
+  struct Slot {
+    T value{};
+    std::uint32_t generation{};
+    bool used{};
+  };
+
+  static constexpr unsigned kIndexBits = 17;
+  static constexpr unsigned kGenerationBits = 31 - kIndexBits;
+  static constexpr ucell kIndexMask = (1u << kIndexBits) - 1;
+  static constexpr ucell kGenerationMask = (1u << kGenerationBits) - 1;
+  static constexpr std::size_t kMaxSlots = kIndexMask;
+  static constexpr std::size_t kMinFreeSlots = 1024;
+
+  static cell MakeHandle(std::size_t index, std::uint32_t generation) {
+    return static_cast<cell>((generation << kIndexBits) | (index + 1));
+  }
+
+  Slot *FindSlot(cell handle) {
+    const auto raw = static_cast<ucell>(handle);
+    const auto index = raw & kIndexMask;
+    if (index == 0 || index > slots_.size()) {
+      return nullptr;
+    }
+
+    auto &slot = slots_[index - 1];
+    if (!slot.used || (raw >> kIndexBits) != slot.generation) {
+      return nullptr;
+    }
+
+    return &slot;
+  }
+
+  std::vector<Slot> slots_;
+  std::deque<std::uint32_t> free_slots_;
+  std::size_t size_{};
+};
+
+#endif  // PAWNREGEX_HANDLE_TABLE_H_
@@ -0,0 +1,115 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "main.h"
+
+void LiteralMatcher::Add(std::string_view literal, std::size_t id) {
+  if (!literal.empty()) {
+    literals_.emplace_back(literal, id);
+  }
+}
+
+void LiteralMatcher::Build() {
+  constexpr auto kNone = std::numeric_limits<std::uint32_t>::max();
+
+  const auto fold = [](unsigned char ch) {
+    return static_cast<unsigned char>(std::tolower(ch));
+  };
+
+  // Class 0 stands for every byte that does not occur in any literal
+  classes_.fill(0);
+  alphabet_size_ = 1;
+
+  for (const auto &[literal, id] : literals_) {
+    for (const auto ch : literal) {
+      const auto folded = fold(ch);
+      if (!classes_[folded]) {
+        classes_[folded] = static_cast<std::uint8_t>(alphabet_size_++);
+      }
+    }
+  }
+
+  for (std::size_t ch{}; ch < classes_.size(); ++ch) {
+    classes_[ch] = classes_[fold(static_cast<unsigned char>(ch))];
+  }
+
+  transitions_.assign(alphabet_size_, kNone);
+  outputs_.assign(1, {});
+
+  for (const auto &[literal, id] : literals_) {
+    std::uint32_t state{};
+
+    for (const auto ch : literal) {
+      auto &next = transitions_[state * alphabet_size_ +
+                                classes_[static_cast<unsigned char>(ch)]];
+      if (next == kNone) {
+        next = static_cast<std::uint32_t>(outputs_.size());
+
+        outputs_.emplace_back();
+
+        transitions_.resize(transitions_.size() + alphabet_size_, kNone);
+      }
+
+      state = transitions_[state * alphabet_size_ +
+                           classes_[static_cast<unsigned char>(ch)]];
+    }
+
+    outputs_[state].push_back(id);
+  }
+
+  // Breadth-first pass turning the trie into a complete automaton
+  std::vector<std::uint32_t> fail(outputs_.size());
+  std::vector<std::uint32_t> queue;
+
+  for (std::size_t cls{}; cls < alphabet_size_; ++cls) {
+    auto &next = transitions_[cls];
+    if (next == kNone) {
+      next = 0;
+    } else if (next) {
+      queue.push_back(next);
+    }
+  }
+
+  for (std::size_t head{}; head < queue.size(); ++head) {
+    const auto state = queue[head];
+
+    for (std::size_t cls{}; cls < alphabet_size_; ++cls) {
+      auto &next = transitions_[state * alphabet_size_ + cls];
+      const auto fallback = transitions_[fail[state] * alphabet_size_ + cls];
+
+      if (next == kNone) {
+        next = fallback;
+
+        continue;
+      }
+
+      fail[next] = fallback;
+
+      outputs_[next].insert(outputs_[next].end(), outputs_[fallback].begin(),
+                            outputs_[fallback].end());
+
+      queue.push_back(next);
+    }
+  }
+}
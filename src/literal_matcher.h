@@ -0,0 +1,58 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PAWNREGEX_LITERAL_MATCHER_H_
+#define PAWNREGEX_LITERAL_MATCHER_H_
+
+// Aho-Corasick automaton over a set of literals. It ignores ASCII case, so it
+// prefilters case-sensitive and REGEX_ICASE patterns alike.
+class LiteralMatcher {
+ public:
+  void Add(std::string_view literal, std::size_t id);
+
+  void Build();
+
+  template <typename Func>
+  void Scan(const char *first, const char *last, Func on_match) const {
+    std::uint32_t state{};
+
+    for (; first != last; ++first) {
+      state = transitions_[state * alphabet_size_ +
+                           classes_[static_cast<unsigned char>(*first)]];
+
+      for (const auto id : outputs_[state]) {
+        on_match(id);
+      }
+    }
+  }
+
+ private:
+  std::vector<std::pair<std::string, std::size_t>> literals_;
+  std::array<std::uint8_t, 256> classes_{};
+  std::size_t alphabet_size_{1};
+  std::vector<std::uint32_t> transitions_{0};
+  std::vector<std::vector<std::size_t>> outputs_{1};
+};
+
+#endif  // PAWNREGEX_LITERAL_MATCHER_H_
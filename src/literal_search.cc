@@ -0,0 +1,256 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "main.h"
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define PAWNREGEX_X86
+#define PAWNREGEX_TARGET(isa) __attribute__((target(isa)))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define PAWNREGEX_X86
+#define PAWNREGEX_TARGET(isa)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace {
+
+using FindFunc = const char *(*)(const char *first, const char *last,
+                                 std::string_view literal, bool icase);
+
+char OtherCase(char ch) {
+  if (ch >= 'a' && ch <= 'z') {
+    return static_cast<char>(ch - 'a' + 'A');
+  }
+
+  if (ch >= 'A' && ch <= 'Z') {
+    return static_cast<char>(ch - 'A' + 'a');
+  }
+
+  return ch;
+}
+
+bool Equals(const char *str, std::string_view literal, bool icase) {
+  if (!icase) {
+    return std::memcmp(str, literal.data(), literal.size()) == 0;
+  }
+
+  for (std::size_t i{}; i < literal.size(); ++i) {
+    if (str[i] != literal[i] && str[i] != OtherCase(literal[i])) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+const char *FindScalar(const char *first, const char *last,
+                       std::string_view literal, bool icase) {
+  if (literal.empty()) {
+    return first;
+  }
+
+  if (static_cast<std::size_t>(last - first) < literal.size()) {
+    return last;
+  }
+
+  const auto end = last - literal.size() + 1;
+  const auto head = literal[0];
+  const auto other_head = icase ? OtherCase(head) : head;
+
+  for (auto p = first; p != end; ++p) {
+    if (head == other_head) {
+      p = static_cast<const char *>(std::memchr(p, head, end - p));
+      if (!p) {
+        return last;
+      }
+    } else if (*p != head && *p != other_head) {
+      continue;
+    }
+
+    if (Equals(p, literal, icase)) {
+      return p;
+    }
+  }
+
+  return last;
+}
+
+#ifdef PAWNREGEX_X86
+int CountTrailingZeros(unsigned mask) {
+#ifdef _MSC_VER
+  unsigned long index{};
+  _BitScanForward(&index, mask);
+
+  return static_cast<int>(index);
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+
+// Both kernels test the first and last character of the literal on a block
+// of positions at once
+PAWNREGEX_TARGET("sse2")
+const char *FindSse2(const char *first, const char *last,
+                     std::string_view literal, bool icase) {
+  const auto size = literal.size();
+  if (size < 2 || static_cast<std::size_t>(last - first) < size + 16) {
+    return FindScalar(first, last, literal, icase);
+  }
+
+  const auto first_char = literal[0];
+  const auto last_char = literal[size - 1];
+  const auto other_first = icase ? OtherCase(first_char) : first_char;
+  const auto other_last = icase ? OtherCase(last_char) : last_char;
+
+  const auto head = _mm_set1_epi8(first_char);
+  const auto other_head = _mm_set1_epi8(other_first);
+  const auto tail = _mm_set1_epi8(last_char);
+  const auto other_tail = _mm_set1_epi8(other_last);
+
+  const auto end = last - size + 1;
+
+  auto p = first;
+  for (; p + 16 <= end; p += 16) {
+    const auto heads =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    const auto tails =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + size - 1));
+
+    auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(heads, head),
+                     _mm_cmpeq_epi8(heads, other_head)),
+        _mm_or_si128(_mm_cmpeq_epi8(tails, tail),
+                     _mm_cmpeq_epi8(tails, other_tail)))));
+
+    while (mask) {
+      const auto candidate = p + CountTrailingZeros(mask);
+      if (Equals(candidate, literal, icase)) {
+        return candidate;
+      }
+
+      mask &= mask - 1;
+    }
+  }
+
+  return FindScalar(p, last, literal, icase);
+}
+
+PAWNREGEX_TARGET("avx2")
+const char *FindAvx2(const char *first, const char *last,
+                     std::string_view literal, bool icase) {
+  const auto size = literal.size();
+  if (size < 2 || static_cast<std::size_t>(last - first) < size + 32) {
+    return FindScalar(first, last, literal, icase);
+  }
+
+  const auto first_char = literal[0];
+  const auto last_char = literal[size - 1];
+  const auto other_first = icase ? OtherCase(first_char) : first_char;
+  const auto other_last = icase ? OtherCase(last_char) : last_char;
+
+  const auto head = _mm256_set1_epi8(first_char);
+  const auto other_head = _mm256_set1_epi8(other_first);
+  const auto tail = _mm256_set1_epi8(last_char);
+  const auto other_tail = _mm256_set1_epi8(other_last);
+
+  const auto end = last - size + 1;
+
+  auto p = first;
+  for (; p + 32 <= end; p += 32) {
+    const auto heads =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    const auto tails =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + size - 1));
+
+    auto mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_and_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(heads, head),
+                        _mm256_cmpeq_epi8(heads, other_head)),
+        _mm256_or_si256(_mm256_cmpeq_epi8(tails, tail),
+                        _mm256_cmpeq_epi8(tails, other_tail)))));
+
+    while (mask) {
+      const auto candidate = p + CountTrailingZeros(mask);
+      if (Equals(candidate, literal, icase)) {
+        return candidate;
+      }
+
+      mask &= mask - 1;
+    }
+  }
+
+  return FindScalar(p, last, literal, icase);
+}
+#endif  // PAWNREGEX_X86
+
+FindFunc SelectKernel() {
+#if defined(PAWNREGEX_X86) && defined(_MSC_VER)
+  int info[4]{};
+
+  __cpuid(info, 0);
+  const auto max_leaf = info[0];
+
+  __cpuid(info, 1);
+  const bool sse2 = info[3] & (1 << 26);
+  const bool avx_os = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) &&
+                      (_xgetbv(0) & 6) == 6;
+
+  bool avx2{};
+  if (max_leaf >= 7) {
+    __cpuidex(info, 7, 0);
+
+    avx2 = avx_os && (info[1] & (1 << 5));
+  }
+
+  if (avx2) {
+    return &FindAvx2;
+  }
+
+  if (sse2) {
+    return &FindSse2;
+  }
+#elif defined(PAWNREGEX_X86)
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx2")) {
+    return &FindAvx2;
+  }
+
+  if (__builtin_cpu_supports("sse2")) {
+    return &FindSse2;
+  }
+#endif
+
+  return &FindScalar;
+}
+
+const FindFunc find_kernel = SelectKernel();
+
+}  // namespace
+
+const char *FindLiteral(const char *first, const char *last,
+                        std::string_view literal, bool icase) {
+  return find_kernel(first, last, literal, icase);
+}
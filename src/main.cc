@@ -25,7 +25,7 @@
 #include "main.h"
 
 PLUGIN_EXPORT unsigned int PLUGIN_CALL Supports() {
-  return SUPPORTS_VERSION | SUPPORTS_AMX_NATIVES;
+  return SUPPORTS_VERSION | SUPPORTS_AMX_NATIVES | SUPPORTS_PROCESS_TICK;
 }
 
 PLUGIN_EXPORT bool PLUGIN_CALL Load(void **ppData) {
@@ -35,3 +35,11 @@ PLUGIN_EXPORT bool PLUGIN_CALL Load(void **ppData) {
 PLUGIN_EXPORT void PLUGIN_CALL Unload() { Plugin::DoUnload(); }
 
 PLUGIN_EXPORT void PLUGIN_CALL AmxLoad(AMX *amx) { Plugin::DoAmxLoad(amx); }
+
+PLUGIN_EXPORT void PLUGIN_CALL AmxUnload(AMX *amx) {
+  Plugin::DoAmxUnload(amx);
+}
+
+PLUGIN_EXPORT void PLUGIN_CALL ProcessTick() {
+  Plugin::Instance().OnProcessTick();
+}
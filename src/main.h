@@ -25,16 +25,57 @@
 #ifndef PAWNREGEX_MAIN_H_
 #define PAWNREGEX_MAIN_H_
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <regex>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
 #include "samp-ptl/ptl.h"
 #include "cpptoml/include/cpptoml.h"
+#include "re2/re2.h"
 
 #include "Pawn.Regex.inc"
 
+#include "amx_string.h"
+#include "handle_table.h"
+#include "memory_usage.h"
+#include "utf8.h"
+#include "regex_traits.h"
+#include "match_budget.h"
+#include "profiler.h"
+#include "group_names.h"
+#include "match_results.h"
+#include "pattern_info.h"
+#include "literal_matcher.h"
+#include "literal_search.h"
+#include "regex.h"
+#include "regex_set.h"
+#include "regex_stream.h"
 #include "script.h"
+#include "regex_cache.h"
+#include "regex_registry.h"
+#include "worker_pool.h"
+#include "pattern_bundle.h"
 #include "native_param.h"
 #include "plugin.h"
 
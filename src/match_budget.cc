@@ -0,0 +1,50 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "main.h"
+
+MatchBudget::MatchBudget(const MatchLimit &limit)
+    : timed_{limit.time.count() > 0},
+      steps_left_{limit.steps ? limit.steps
+                              : std::numeric_limits<std::size_t>::max()} {
+  if (timed_) {
+    deadline_ = std::chrono::steady_clock::now() + limit.time;
+  }
+
+  chunk_ = countdown_ = std::min(steps_left_, kCheckInterval);
+}
+
+void MatchBudget::Refill() {
+  steps_left_ -= chunk_;
+
+  if (!steps_left_) {
+    throw MatchTimeout{"Match step limit exceeded"};
+  }
+
+  if (timed_ && std::chrono::steady_clock::now() > deadline_) {
+    throw MatchTimeout{"Match time limit exceeded"};
+  }
+
+  chunk_ = countdown_ = std::min(steps_left_, kCheckInterval);
+}
@@ -0,0 +1,280 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PAWNREGEX_MATCH_BUDGET_H_
+#define PAWNREGEX_MATCH_BUDGET_H_
+
+// Upper bound on the work done by one matching call. Zero means unlimited.
+struct MatchLimit {
+  std::chrono::microseconds time{};
+  std::size_t steps{};
+};
+
+class MatchTimeout : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+// Work left for one matching call. A step is one move over the subject, so
+// backtracking pays for every character it rereads.
+class MatchBudget {
+ public:
+  explicit MatchBudget(const MatchLimit &limit);
+
+  void Step() {
+    if (--countdown_ == 0) {
+      Refill();
+    }
+  }
+
+ private:
+  static constexpr std::size_t kCheckInterval = 1024;
+
+  void Refill();
+
+  std::chrono::steady_clock::time_point deadline_;
+  bool timed_{};
+  std::size_t steps_left_{};
+  std::size_t chunk_{};
+  std::size_t countdown_{};
+};
+
+// Subject pointer that charges every move to a MatchBudget
+class SubjectIterator {
+ public:
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = char;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const char *;
+  using reference = const char &;
+
+  SubjectIterator() = default;
+
+  SubjectIterator(const char *ptr, MatchBudget *budget)
+      : ptr_{ptr}, budget_{budget} {}
+
+  reference operator*() const { return *ptr_; }
+
+  pointer operator->() const { return ptr_; }
+
+  SubjectIterator &operator++() {
+    budget_->Step();
+
+    ++ptr_;
+
+    return *this;
+  }
+
+  SubjectIterator operator++(int) {
+    auto prev = *this;
+
+    ++*this;
+
+    return prev;
+  }
+
+  SubjectIterator &operator--() {
+    budget_->Step();
+
+    --ptr_;
+
+    return *this;
+  }
+
+  SubjectIterator operator--(int) {
+    auto prev = *this;
+
+    --*this;
+
+    return prev;
+  }
+
+  bool operator==(const SubjectIterator &other) const {
+    return ptr_ == other.ptr_;
+  }
+
+  bool operator!=(const SubjectIterator &other) const {
+    return ptr_ != other.ptr_;
+  }
+
+  const char *base() const { return ptr_; }
+
+  // Iterator at ptr that charges the same budget
+  SubjectIterator At(const char *ptr) const { return {ptr, budget_}; }
+
+ private:
+  const char *ptr_{};
+  MatchBudget *budget_{};
+};
+
+// SubjectIterator over the code points of UTF-8, base() is still in bytes.
+// Nothing below floor is read but the byte match_prev_avail promises.
+class Utf8SubjectIterator {
+ public:
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = wchar_t;
+  using difference_type = std::ptrdiff_t;
+  using pointer = void;
+  using reference = wchar_t;
+
+  Utf8SubjectIterator() = default;
+
+  Utf8SubjectIterator(const char *ptr, const char *floor, const char *last,
+                      MatchBudget *budget)
+      : ptr_{ptr}, floor_{floor}, last_{last}, budget_{budget} {}
+
+  reference operator*() const {
+    if (ptr_ < floor_) {
+      const auto byte = static_cast<unsigned char>(*ptr_);
+
+      return byte < 0x80 ? byte : kReplacementChar;
+    }
+
+    wchar_t ch{};
+
+    DecodeUtf8(ptr_, last_, ch);
+
+    return ch;
+  }
+
+  Utf8SubjectIterator &operator++() {
+    budget_->Step();
+
+    if (ptr_ < floor_) {
+      ++ptr_;
+    } else {
+      wchar_t ch{};
+
+      ptr_ += DecodeUtf8(ptr_, last_, ch);
+    }
+
+    return *this;
+  }
+
+  Utf8SubjectIterator operator++(int) {
+    auto prev = *this;
+
+    ++*this;
+
+    return prev;
+  }
+
+  Utf8SubjectIterator &operator--() {
+    budget_->Step();
+
+    // Back over the continuation bytes, as long as they and the byte before
+    // them form one valid character that ends here
+    auto first = ptr_ - 1;
+    while (first > floor_ && ptr_ - first < 4 &&
+           (static_cast<unsigned char>(*first) & 0xC0) == 0x80) {
+      --first;
+    }
+
+    wchar_t ch{};
+    if (first >= floor_ && first + DecodeUtf8(first, ptr_, ch) == ptr_) {
+      ptr_ = first;
+    } else {
+      --ptr_;
+    }
+
+    return *this;
+  }
+
+  Utf8SubjectIterator operator--(int) {
+    auto prev = *this;
+
+    --*this;
+
+    return prev;
+  }
+
+  bool operator==(const Utf8SubjectIterator &other) const {
+    return ptr_ == other.ptr_;
+  }
+
+  bool operator!=(const Utf8SubjectIterator &other) const {
+    return ptr_ != other.ptr_;
+  }
+
+  const char *base() const { return ptr_; }
+
+  // Iterator at ptr that charges the same budget
+  Utf8SubjectIterator At(const char *ptr) const {
+    return {ptr, floor_, last_, budget_};
+  }
+
+ private:
+  const char *ptr_{};
+  const char *floor_{};
+  const char *last_{};
+  MatchBudget *budget_{};
+};
+
+// Groups of a match as pointers into the subject, whatever iterator the engine
+// ran on
+class SubjectMatch {
+ public:
+  struct Group {
+    const char *first{};
+    const char *second{};
+    bool matched{};
+  };
+
+  template <typename Results>
+  void Assign(const Results &results) {
+    groups_.resize(results.size());
+
+    for (std::size_t i{}; i < results.size(); ++i) {
+      const auto &item = results[i];
+
+      groups_[i] = {item.first.base(), item.second.base(), item.matched};
+    }
+  }
+
+  // Groups found by RE2. Unmatched ones sit at last, as with std::sub_match.
+  template <typename Piece>
+  void Assign(const Piece *pieces, std::size_t count, const char *last) {
+    groups_.resize(count);
+
+    for (std::size_t i{}; i < count; ++i) {
+      const auto first = pieces[i].data();
+
+      groups_[i] = first ? Group{first, first + pieces[i].size(), true}
+                         : Group{last, last, false};
+    }
+  }
+
+  std::size_t size() const { return groups_.size(); }
+
+  const Group &operator[](std::size_t index) const { return groups_[index]; }
+
+  std::vector<Group>::const_iterator begin() const { return groups_.begin(); }
+
+  std::vector<Group>::const_iterator end() const { return groups_.end(); }
+
+ private:
+  std::vector<Group> groups_;
+};
+
+#endif  // PAWNREGEX_MATCH_BUDGET_H_
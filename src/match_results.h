@@ -0,0 +1,127 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PAWNREGEX_MATCH_RESULTS_H_
+#define PAWNREGEX_MATCH_RESULTS_H_
+
+// Groups of a successful match as offsets into a stored copy of the subject
+class MatchResults {
+ public:
+  struct Group {
+    std::size_t offset{};
+    std::size_t length{};
+    bool matched{};
+  };
+
+  void Assign(const char *first, const char *last,
+              const SubjectMatch &results) {
+    SetSubject(first, last);
+
+    Append(first, results);
+  }
+
+  void SetSubject(const char *first, const char *last) {
+    subject_.assign(first, last);
+
+    groups_.clear();
+
+    group_count_ = 0;
+
+    group_names_.reset();
+  }
+
+  // Lets the groups be found by name, see Regex::GetGroupNames
+  void SetGroupNames(GroupNamesPtr group_names) {
+    group_names_ = std::move(group_names);
+  }
+
+  // first must point to the beginning of the subject the results refer to
+  void Append(const char *first, const SubjectMatch &results) {
+    group_count_ = results.size();
+
+    for (const auto &item : results) {
+      groups_.push_back({static_cast<std::size_t>(item.first - first),
+                         static_cast<std::size_t>(item.second - item.first),
+                         item.matched});
+    }
+  }
+
+  std::size_t GetMatchCount() const {
+    return group_count_ ? groups_.size() / group_count_ : 0;
+  }
+
+  std::size_t GetGroupCount() const { return group_count_; }
+
+  // Bytes held by the results, see Regex_GetMemoryUsage
+  std::size_t GetMemorySize() const {
+    return sizeof(*this) + subject_.capacity() +
+           groups_.capacity() * sizeof(Group);
+  }
+
+  const Group &GetGroup(std::size_t index) const { return GetGroup(0, index); }
+
+  const Group &GetGroup(std::size_t match, std::size_t index) const {
+    if (index >= group_count_) {
+      throw std::out_of_range{"Invalid group index"};
+    }
+
+    return groups_.at(match * group_count_ + index);
+  }
+
+  std::string_view GetGroupString(std::size_t index) const {
+    return GetGroupString(0, index);
+  }
+
+  std::size_t GetGroupIndex(std::string_view name) const {
+    const auto index = group_names_ ? group_names_->Find(name) : -1;
+    if (index < 0) {
+      throw std::out_of_range{"Invalid group name"};
+    }
+
+    return index;
+  }
+
+  std::string_view GetGroupString(std::size_t match, std::size_t index) const {
+    const auto &group = GetGroup(match, index);
+    if (!group.matched) {
+      return {};
+    }
+
+    return std::string_view{subject_}.substr(group.offset, group.length);
+  }
+
+ private:
+  std::string subject_;
+  std::vector<Group> groups_;
+  std::size_t group_count_{};
+  GroupNamesPtr group_names_;
+};
+
+// Every match of a pattern in one subject, see Regex_SearchAll
+class MatchList : public MatchResults {};
+
+using MatchResultsPtr = std::shared_ptr<MatchResults>;
+using MatchListPtr = std::shared_ptr<MatchList>;
+
+#endif  // PAWNREGEX_MATCH_RESULTS_H_
@@ -0,0 +1,125 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PAWNREGEX_MEMORY_USAGE_H_
+#define PAWNREGEX_MEMORY_USAGE_H_
+
+enum class MemoryKind {
+  kRegex,  // Regex, regex set and stream handles, set members
+  kMatch,  // Match and match list handles
+};
+
+// Caps from pawnregex.cfg, zero means unlimited
+struct MemoryLimits {
+  std::size_t regexes{};      // Regex handles of one script
+  std::size_t matches{};      // Match and match list handles of one script
+  std::size_t bytes{};        // Bytes held by the handles of one script
+  std::size_t total_bytes{};  // Bytes held by the handles of all scripts
+};
+
+class MemoryLimitError : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+// Live handles and the bytes they hold, with the peaks of both. An object
+// held by several handles (e.g. a cached regex) is counted for each of them.
+class MemoryUsage {
+ public:
+  void Add(MemoryKind kind, std::size_t bytes) {
+    auto &counter = counters_[static_cast<std::size_t>(kind)];
+
+    ++counter.count;
+    counter.bytes += bytes;
+
+    counter.peak_count = std::max(counter.peak_count, counter.count);
+    counter.peak_bytes = std::max(counter.peak_bytes, counter.bytes);
+
+    peak_bytes_ = std::max(peak_bytes_, GetBytes());
+  }
+
+  void Remove(MemoryKind kind, std::size_t bytes) {
+    auto &counter = counters_[static_cast<std::size_t>(kind)];
+
+    --counter.count;
+    counter.bytes -= bytes;
+  }
+
+  // A handle that is already counted now holds new_bytes
+  void Resize(MemoryKind kind, std::size_t old_bytes, std::size_t new_bytes) {
+    auto &counter = counters_[static_cast<std::size_t>(kind)];
+
+    counter.bytes = counter.bytes - old_bytes + new_bytes;
+
+    counter.peak_bytes = std::max(counter.peak_bytes, counter.bytes);
+
+    peak_bytes_ = std::max(peak_bytes_, GetBytes());
+  }
+
+  // Removes everything another usage (e.g. of an unloaded script) holds
+  void Remove(const MemoryUsage &usage) {
+    for (std::size_t i{}; i < counters_.size(); ++i) {
+      counters_[i].count -= usage.counters_[i].count;
+      counters_[i].bytes -= usage.counters_[i].bytes;
+    }
+  }
+
+  std::size_t GetCount(MemoryKind kind) const {
+    return counters_[static_cast<std::size_t>(kind)].count;
+  }
+
+  std::size_t GetBytes(MemoryKind kind) const {
+    return counters_[static_cast<std::size_t>(kind)].bytes;
+  }
+
+  std::size_t GetBytes() const {
+    return GetBytes(MemoryKind::kRegex) + GetBytes(MemoryKind::kMatch);
+  }
+
+  std::size_t GetPeakCount(MemoryKind kind) const {
+    return counters_[static_cast<std::size_t>(kind)].peak_count;
+  }
+
+  std::size_t GetPeakBytes(MemoryKind kind) const {
+    return counters_[static_cast<std::size_t>(kind)].peak_bytes;
+  }
+
+  std::size_t GetPeakBytes() const { return peak_bytes_; }
+
+  // E.g. "2 regexes (3120 bytes), 10 matches (1240 bytes)"
+  std::string ToString(bool peak) const;
+
+ private:
+  struct Counter {
+    std::size_t count{};
+    std::size_t bytes{};
+    std::size_t peak_count{};
+    std::size_t peak_bytes{};
+  };
+
+  std::array<Counter, 2> counters_{};
+  std::size_t peak_bytes_{};
+};
+
+#endif  // PAWNREGEX_MEMORY_USAGE_H_
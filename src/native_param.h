@@ -32,9 +32,17 @@ struct NativeParam : Script::NativeParam {
 
   operator E_MATCH_FLAG() { return static_cast<E_MATCH_FLAG>(raw_value); };
 
-  operator RegexPtr() { return script.GetRegex(raw_value); }
+  operator AmxString() { return AmxString{static_cast<cell *>(*this)}; }
+
+  operator RegexRef() { return script.GetRegex(raw_value); }
 
   operator MatchResultsPtr() { return script.GetMatchResults(raw_value); };
+
+  operator RegexSetPtr() { return script.GetRegexSet(raw_value); }
+
+  operator MatchListPtr() { return script.GetMatchList(raw_value); }
+
+  operator RegexStreamPtr() { return script.GetRegexStream(raw_value); }
 };
 
 #endif  // PAWNREGEX_NATIVE_PARAM_H_
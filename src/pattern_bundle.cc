@@ -0,0 +1,170 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "main.h"
+
+std::vector<std::string> PatternBundle::Load(const std::string &path,
+                                             WorkerPool &pool) {
+  const auto bundle = cpptoml::parse_file(path);
+
+  std::vector<Entry> entries;
+  std::vector<std::string> errors;
+
+  for (const auto &[name, value] : *bundle) {
+    try {
+      entries.push_back(ParseEntry(name, value));
+    } catch (const std::exception &e) {
+      errors.push_back("Pattern " + name + ": " + e.what());
+    }
+  }
+
+  auto compile_errors = Compile(std::move(entries), pool);
+
+  errors.insert(errors.end(), compile_errors.begin(), compile_errors.end());
+
+  return errors;
+}
+
+std::vector<std::string> PatternBundle::Compile(std::vector<Entry> entries,
+                                                WorkerPool &pool) {
+  auto &plugin = Plugin::Instance();
+
+  std::vector<RegexPtr> regexes(entries.size());
+  std::vector<std::string> errors(entries.size());
+
+  pool.ParallelFor(
+      entries.size(), 1, [&](std::size_t first, std::size_t last) {
+        for (auto i = first; i < last; ++i) {
+          try {
+            regexes[i] = std::make_shared<Regex>(
+                entries[i].pattern, entries[i].option, entries[i].mode,
+                entries[i].engine, plugin.GetEngineLocales());
+          } catch (const std::exception &e) {
+            errors[i] = "Pattern " + entries[i].name + ": " + e.what();
+          }
+        }
+      });
+
+  auto &cache = plugin.GetRegexCache();
+
+  for (std::size_t i{}; i < entries.size(); ++i) {
+    if (!regexes[i]) {
+      continue;
+    }
+
+    if (Profiler::IsEnabled()) {
+      plugin.GetProfiler().AddRegex(regexes[i]);
+    }
+
+    // Regex_New and the *P natives get the compiled pattern as well
+    cache.Add(entries[i].pattern, entries[i].option, entries[i].mode,
+              entries[i].engine, regexes[i]);
+
+    regexes_[std::move(entries[i].name)] = std::move(regexes[i]);
+  }
+
+  errors.erase(std::remove(errors.begin(), errors.end(), std::string{}),
+               errors.end());
+
+  return errors;
+}
+
+RegexPtr PatternBundle::Find(const std::string &name) const {
+  const auto iter = regexes_.find(name);
+
+  return iter == regexes_.end() ? nullptr : iter->second;
+}
+
+PatternBundle::Entry PatternBundle::ParseEntry(
+    const std::string &name, const std::shared_ptr<cpptoml::base> &value) {
+  const static std::unordered_map<std::string, E_REGEX_FLAG> flag_map{
+      {"icase", REGEX_ICASE},
+      {"nosubs", REGEX_NOSUBS},
+      {"optimize", REGEX_OPTIMIZE},
+      {"collate", REGEX_COLLATE},
+      {"locale", REGEX_LOCALE},
+      {"bytes", REGEX_BYTES},
+      {"utf8", REGEX_UTF8},
+      {"std", REGEX_STD},
+      {"re2", REGEX_RE2},
+  };
+
+  const static std::unordered_map<std::string, E_REGEX_GRAMMAR> grammar_map{
+      {"ecmascript", REGEX_ECMASCRIPT}, {"basic", REGEX_BASIC},
+      {"extended", REGEX_EXTENDED},     {"awk", REGEX_AWK},
+      {"grep", REGEX_GREP},             {"egrep", REGEX_EGREP},
+  };
+
+  Entry entry;
+
+  entry.name = name;
+
+  if (const auto pattern = value->as<std::string>()) {
+    entry.pattern = pattern->get();
+    entry.option = Script::GetRegexFlag(REGEX_DEFAULT, REGEX_ECMASCRIPT);
+    entry.mode = Script::GetCharMode(REGEX_DEFAULT);
+    entry.engine = Script::GetEngine(REGEX_DEFAULT);
+
+    return entry;
+  }
+
+  const auto table = value->as_table();
+  if (!table) {
+    throw std::runtime_error{"expected a string or a table"};
+  }
+
+  const auto pattern = table->get_as<std::string>("pattern");
+  if (!pattern) {
+    throw std::runtime_error{"missing pattern"};
+  }
+
+  entry.pattern = *pattern;
+
+  int flags = REGEX_DEFAULT;
+
+  for (const auto &flag : table->get_array_of<std::string>("flags")
+                              .value_or(std::vector<std::string>{})) {
+    const auto iter = flag_map.find(flag);
+    if (iter == flag_map.end()) {
+      throw std::runtime_error{"unknown flag " + flag};
+    }
+
+    flags |= iter->second;
+  }
+
+  const auto grammar =
+      table->get_as<std::string>("grammar").value_or("ecmascript");
+
+  const auto iter = grammar_map.find(grammar);
+  if (iter == grammar_map.end()) {
+    throw std::runtime_error{"unknown grammar " + grammar};
+  }
+
+  entry.option =
+      Script::GetRegexFlag(static_cast<E_REGEX_FLAG>(flags), iter->second);
+  entry.mode = Script::GetCharMode(static_cast<E_REGEX_FLAG>(flags));
+  entry.engine = Script::GetEngine(static_cast<E_REGEX_FLAG>(flags));
+
+  return entry;
+}
@@ -0,0 +1,59 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PAWNREGEX_PATTERN_BUNDLE_H_
+#define PAWNREGEX_PATTERN_BUNDLE_H_
+
+// Named patterns compiled when the plugin loads, see Regex_Get
+class PatternBundle {
+ public:
+  struct Entry {
+    std::string name;
+    std::string pattern;
+    std::regex_constants::syntax_option_type option{};
+    CharMode mode{};
+    RegexEngine engine{};
+  };
+
+  // Reads the bundle and compiles it, see Compile
+  std::vector<std::string> Load(const std::string &path, WorkerPool &pool);
+
+  // Compiles the entries on the pool into the bundle and the regex cache.
+  // Returns an error for every pattern that did not compile.
+  std::vector<std::string> Compile(std::vector<Entry> entries,
+                                   WorkerPool &pool);
+
+  // Returns nullptr if there is no such pattern
+  RegexPtr Find(const std::string &name) const;
+
+  std::size_t Size() const { return regexes_.size(); }
+
+ private:
+  static Entry ParseEntry(const std::string &name,
+                          const std::shared_ptr<cpptoml::base> &value);
+
+  std::unordered_map<std::string, RegexPtr> regexes_;
+};
+
+#endif  // PAWNREGEX_PATTERN_BUNDLE_H_
@@ -0,0 +1,539 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "main.h"
+
+PatternInfo::PatternInfo(std::string_view pattern,
+                         std::regex_constants::syntax_option_type option,
+                         CharMode mode) {
+  constexpr auto kOtherGrammars =
+      std::regex_constants::basic | std::regex_constants::extended |
+      std::regex_constants::awk | std::regex_constants::grep |
+      std::regex_constants::egrep;
+
+  if (option & kOtherGrammars) {
+    return;
+  }
+
+  if (const auto alternatives = SplitAlternatives(pattern);
+      alternatives.size() > 1) {
+    for (const auto alternative : alternatives) {
+      const PatternInfo info{alternative, option, mode};
+      if (info.required_literal_.empty()) {
+        alternative_literals_.clear();
+
+        break;
+      }
+
+      alternative_literals_.push_back(info.required_literal_);
+    }
+
+    // An alternative may avoid any literal on the other side
+    return;
+  }
+
+  const bool icase = (option & std::regex_constants::icase) != 0;
+
+  // Reads the character at i into ch and returns its length. A UTF-8
+  // character is one atom, so a quantifier applies to all its bytes.
+  const auto read_char = [&pattern, mode](std::size_t i,
+                                          std::string_view &ch) {
+    std::size_t length = 1;
+
+    if (mode == CharMode::kUtf8) {
+      wchar_t code{};
+
+      length = DecodeUtf8(pattern.data() + i, pattern.data() + pattern.size(),
+                          code);
+
+      // The engine reads it as U+FFFD, which stands for other bytes too
+      if (code == kReplacementChar) {
+        ch = {};
+
+        return length;
+      }
+    }
+
+    ch = pattern.substr(i, length);
+
+    return length;
+  };
+
+  std::string run, best, prefix;
+  std::size_t min_length{};
+  bool at_start = true, literal = !icase;
+
+  const auto flush = [&run, &best, &prefix, &at_start] {
+    // Only the run that opens the pattern is a prefix of every match
+    if (at_start) {
+      prefix = run;
+
+      at_start = false;
+    }
+
+    if (run.size() > best.size()) {
+      best = run;
+    }
+
+    run.clear();
+  };
+
+  std::size_t i{};
+  bool anchored{};
+  if (!pattern.empty() && pattern[0] == '^') {
+    anchored = true;
+
+    literal = false;
+
+    ++i;
+  }
+
+  while (i < pattern.size()) {
+    std::string_view ch;
+
+    switch (pattern[i]) {
+      case '(':
+      case '[':
+      case '.':
+      case '^':
+      case '$': {
+        flush();
+
+        literal = false;
+
+        const auto atom = pattern[i];
+
+        bool skipped = true;
+        if (atom == '(') {
+          skipped = SkipGroup(pattern, i);
+        } else if (atom == '[') {
+          skipped = SkipClass(pattern, i);
+        } else {
+          ++i;
+        }
+
+        std::size_t min_repeat{};
+        if (!skipped || !SkipQuantifier(pattern, i, min_repeat)) {
+          return;
+        }
+
+        // Groups may be empty and anchors are zero-width
+        if (atom == '[' || atom == '.') {
+          min_length += min_repeat;
+        }
+
+        continue;
+      }
+      case ')':
+      case ']':
+      case '}':
+      case '*':
+      case '+':
+      case '?':
+      case '{':
+        return;
+      case '\\': {
+        if (i + 1 >= pattern.size()) {
+          return;
+        }
+
+        const auto escaped = static_cast<unsigned char>(pattern[i + 1]);
+        if (std::isalnum(escaped)) {
+          // Character class, assertion, control or numeric escape: skip the
+          // whole sequence and break the literal run
+          const auto extra = escaped == 'x'   ? 2
+                             : escaped == 'u' ? 4
+                             : escaped == 'c' ? 1
+                                              : 0;
+
+          i += 2 + extra;
+
+          while (std::isdigit(escaped) && i < pattern.size() &&
+                 std::isdigit(static_cast<unsigned char>(pattern[i]))) {
+            ++i;
+          }
+
+          flush();
+
+          literal = false;
+
+          std::size_t min_repeat{};
+          if (i > pattern.size() || !SkipQuantifier(pattern, i, min_repeat)) {
+            return;
+          }
+
+          // Word boundaries and back-references may match nothing
+          if (escaped != 'b' && escaped != 'B' && !std::isdigit(escaped)) {
+            min_length += min_repeat;
+          }
+
+          continue;
+        }
+
+        i += 1 + read_char(i + 1, ch);
+
+        break;
+      }
+      default:
+        i += read_char(i, ch);
+
+        break;
+    }
+
+    const auto length = ch.empty() ? 1 : ch.size();
+
+    min_length += length;
+
+    // Case-insensitive matches of non-ASCII characters depend on the locale
+    if (icase && !ch.empty() && (static_cast<unsigned char>(ch[0]) & 0x80)) {
+      ch = {};
+    }
+
+    if (ch.empty()) {
+      flush();
+    }
+
+    std::size_t min_repeat{};
+    const auto quantifier_pos = i;
+    if (!SkipQuantifier(pattern, i, min_repeat)) {
+      return;
+    }
+
+    if (!ch.empty() && min_repeat) {
+      run.append(ch);
+    }
+
+    if (i != quantifier_pos || ch.empty()) {
+      min_length = min_length - length + length * min_repeat;
+
+      literal = false;
+
+      flush();
+    }
+  }
+
+  flush();
+
+  required_literal_ = std::move(best);
+  literal_prefix_ = std::move(prefix);
+  min_length_ = min_length;
+  literal_ = literal && !required_literal_.empty();
+
+  // Only known once the whole pattern is scanned: "^a|b" is not anchored.
+  // MSVC's std::regex also lets "^" match after a line break.
+#ifdef _MSC_VER
+  anchored = false;
+#endif
+
+  anchored_start_ = anchored;
+}
+
+std::size_t PatternInfo::EstimateEngineSize(std::string_view pattern,
+                                            CharMode mode) {
+  // Measured with libstdc++, including the growth of its state vector
+  constexpr std::size_t kBaseSize = 512;
+  constexpr std::size_t kStateSize = 48;
+  constexpr std::size_t kClassSize = 300;
+
+  // Sizes of the enclosing sequences while inside a group
+  std::vector<std::size_t> outer;
+  std::size_t size{}, atom{};
+
+  std::size_t i{};
+  while (i < pattern.size()) {
+    const auto ch = pattern[i];
+
+    switch (ch) {
+      case '\\': {
+        const auto escaped = i + 1 < pattern.size() ? pattern[i + 1] : '\0';
+        const bool is_class = escaped && std::strchr("dDsSwW", escaped);
+
+        atom = is_class ? kStateSize + kClassSize : kStateSize;
+
+        i += 2;
+
+        break;
+      }
+      case '[':
+        if (!SkipClass(pattern, i)) {
+          i = pattern.size();
+        }
+
+        atom = kStateSize + kClassSize;
+
+        break;
+      case '(':
+        outer.push_back(size);
+
+        size = 0;
+        atom = 0;
+
+        ++i;
+
+        continue;
+      case ')':
+        // Groups open and close a subexpression
+        atom = size + 2 * kStateSize;
+
+        size = outer.empty() ? 0 : outer.back();
+
+        if (!outer.empty()) {
+          outer.pop_back();
+        }
+
+        ++i;
+
+        break;
+      case '|':
+        size += 2 * kStateSize;
+        atom = 0;
+
+        ++i;
+
+        continue;
+      case '*':
+      case '+':
+      case '?':
+        size += kStateSize;
+        atom = 0;
+
+        ++i;
+
+        continue;
+      case '{': {
+        const auto close = pattern.find('}', i);
+        if (close == std::string_view::npos) {
+          atom = kStateSize;
+
+          ++i;
+
+          break;
+        }
+
+        std::size_t min{}, max{};
+        bool comma{};
+        for (++i; i < close; ++i) {
+          if (pattern[i] == ',') {
+            comma = true;
+          } else if (std::isdigit(static_cast<unsigned char>(pattern[i]))) {
+            auto &bound = comma ? max : min;
+
+            bound = bound * 10 + (pattern[i] - '0');
+          }
+        }
+
+        // {m} and {m,} unroll m copies, {m,n} unrolls n
+        const auto copies =
+            std::max<std::size_t>(!comma ? min : max ? max : min + 1, 1);
+
+        size += atom * (copies - 1) + kStateSize * copies;
+        atom = 0;
+
+        i = close + 1;
+
+        continue;
+      }
+      default:
+        // A UTF-8 character is one state
+        if (mode == CharMode::kUtf8 &&
+            (static_cast<unsigned char>(ch) & 0xC0) == 0x80) {
+          ++i;
+
+          continue;
+        }
+
+        atom = kStateSize;
+
+        ++i;
+
+        break;
+    }
+
+    size += atom;
+  }
+
+  while (!outer.empty()) {
+    size += outer.back();
+
+    outer.pop_back();
+  }
+
+  return kBaseSize + size;
+}
+
+std::vector<std::string_view> PatternInfo::SplitAlternatives(
+    std::string_view pattern) {
+  std::vector<std::string_view> alternatives;
+
+  std::size_t i{}, start{};
+  while (i < pattern.size()) {
+    switch (pattern[i]) {
+      case '\\':
+        i += 2;
+
+        break;
+      case '[':
+        if (!SkipClass(pattern, i)) {
+          return {pattern};
+        }
+
+        break;
+      case '(':
+        if (!SkipGroup(pattern, i)) {
+          return {pattern};
+        }
+
+        break;
+      case '|':
+        alternatives.push_back(pattern.substr(start, i - start));
+
+        start = ++i;
+
+        break;
+      default:
+        ++i;
+
+        break;
+    }
+  }
+
+  alternatives.push_back(pattern.substr(std::min(start, pattern.size())));
+
+  return alternatives;
+}
+
+bool PatternInfo::SkipClass(std::string_view pattern, std::size_t &i) {
+  ++i;
+
+  if (i < pattern.size() && pattern[i] == '^') {
+    ++i;
+  }
+
+  while (i < pattern.size() && pattern[i] != ']') {
+    i += pattern[i] == '\\' ? 2 : 1;
+  }
+
+  if (i >= pattern.size()) {
+    return false;
+  }
+
+  ++i;
+
+  return true;
+}
+
+bool PatternInfo::SkipGroup(std::string_view pattern, std::size_t &i) {
+  std::size_t depth{};
+
+  while (i < pattern.size()) {
+    switch (pattern[i]) {
+      case '\\':
+        i += 2;
+
+        break;
+      case '[':
+        if (!SkipClass(pattern, i)) {
+          return false;
+        }
+
+        break;
+      case '(':
+        ++depth;
+        ++i;
+
+        break;
+      case ')':
+        ++i;
+
+        if (--depth == 0) {
+          return true;
+        }
+
+        break;
+      default:
+        ++i;
+
+        break;
+    }
+  }
+
+  return false;
+}
+
+bool PatternInfo::SkipQuantifier(std::string_view pattern, std::size_t &i,
+                                 std::size_t &min_repeat) {
+  min_repeat = 1;
+
+  if (i >= pattern.size()) {
+    return true;
+  }
+
+  switch (pattern[i]) {
+    case '*':
+    case '?':
+      min_repeat = 0;
+
+      ++i;
+
+      break;
+    case '+':
+      ++i;
+
+      break;
+    case '{': {
+      const auto close = pattern.find('}', i);
+      if (close == std::string_view::npos) {
+        return false;
+      }
+
+      std::size_t min{}, digits{};
+      for (++i; i < close; ++i, ++digits) {
+        if (!std::isdigit(static_cast<unsigned char>(pattern[i]))) {
+          break;
+        }
+
+        min = min * 10 + (pattern[i] - '0');
+      }
+
+      if (!digits) {
+        return false;
+      }
+
+      min_repeat = min;
+
+      i = close + 1;
+
+      break;
+    }
+    default:
+      return true;
+  }
+
+  // Lazy quantifier
+  if (i < pattern.size() && pattern[i] == '?') {
+    ++i;
+  }
+
+  return true;
+}
@@ -0,0 +1,84 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PAWNREGEX_PATTERN_INFO_H_
+#define PAWNREGEX_PATTERN_INFO_H_
+
+// What is known about an ECMAScript pattern without running the engine.
+// Anything unusual leaves it unknown. Lengths are in bytes.
+class PatternInfo {
+ public:
+  PatternInfo(std::string_view pattern,
+              std::regex_constants::syntax_option_type option, CharMode mode);
+
+  // Literal that occurs in every match of the pattern, empty if unknown
+  const std::string &GetRequiredLiteral() const { return required_literal_; }
+
+  // For a pattern with a top-level "|", the required literal of each
+  // alternative. Every match contains one of them. Empty if any alternative
+  // has none.
+  const std::vector<std::string> &GetAlternativeLiterals() const {
+    return alternative_literals_;
+  }
+
+  // Literal that every match starts with, empty if unknown
+  const std::string &GetLiteralPrefix() const { return literal_prefix_; }
+
+  // Lower bound on the length of a match
+  std::size_t GetMinLength() const { return min_length_; }
+
+  // Every match starts at the beginning of the subject ("^" without a
+  // top-level alternative)
+  bool IsAnchoredStart() const { return anchored_start_; }
+
+  // The pattern is a case-sensitive literal without any special characters,
+  // so it matches exactly GetRequiredLiteral()
+  bool IsLiteral() const { return literal_; }
+
+  // Rough size of the automaton std::regex builds for the pattern
+  static std::size_t EstimateEngineSize(std::string_view pattern,
+                                        CharMode mode);
+
+ private:
+  // Splits at each "|" outside groups and classes. A malformed pattern stays
+  // in one piece.
+  static std::vector<std::string_view> SplitAlternatives(
+      std::string_view pattern);
+
+  static bool SkipClass(std::string_view pattern, std::size_t &i);
+
+  static bool SkipGroup(std::string_view pattern, std::size_t &i);
+
+  static bool SkipQuantifier(std::string_view pattern, std::size_t &i,
+                             std::size_t &min_repeat);
+
+  std::string required_literal_;
+  std::vector<std::string> alternative_literals_;
+  std::string literal_prefix_;
+  std::size_t min_length_{};
+  bool anchored_start_{};
+  bool literal_{};
+};
+
+#endif  // PAWNREGEX_PATTERN_INFO_H_
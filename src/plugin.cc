@@ -27,16 +27,73 @@
 bool Plugin::OnLoad() {
   ReadConfig();
 
+  worker_pool_.Start(worker_threads_);
+
   RegisterNative<&Script::Regex_New>("Regex_New");
+  RegisterNative<&Script::Regex_Get>("Regex_Get");
   RegisterNative<&Script::Regex_Delete>("Regex_Delete");
 
+  RegisterNative<&Script::Regex_Share>("Regex_Share");
+  RegisterNative<&Script::Regex_Import>("Regex_Import");
+  RegisterNative<&Script::Regex_Unshare>("Regex_Unshare");
+
   RegisterNative<&Script::Regex_Check>("Regex_Check");
   RegisterNative<&Script::Regex_Match>("Regex_Match");
   RegisterNative<&Script::Regex_Search>("Regex_Search");
   RegisterNative<&Script::Regex_Replace>("Regex_Replace");
+  RegisterNative<&Script::Regex_ReplaceEx>("Regex_ReplaceEx");
+
+  RegisterNative<&Script::Regex_SearchAsync>("Regex_SearchAsync");
+  RegisterNative<&Script::Regex_ReplaceAsync>("Regex_ReplaceAsync");
+
+  RegisterNative<&Script::Regex_SearchAll>("Regex_SearchAll");
+  RegisterNative<&Script::Regex_SearchAllPos>("Regex_SearchAllPos");
+
+  RegisterNative<&Script::Regex_CheckMany>("Regex_CheckMany");
+  RegisterNative<&Script::Regex_ReplaceMany>("Regex_ReplaceMany");
+
+  RegisterNative<&Script::Regex_CheckP>("Regex_CheckP");
+  RegisterNative<&Script::Regex_ReplaceP>("Regex_ReplaceP");
+  RegisterNative<&Script::Regex_GetCacheStats>("Regex_GetCacheStats");
+
+  RegisterNative<&Script::Regex_GetGroupIndex>("Regex_GetGroupIndex");
+
+  RegisterNative<&Script::Regex_SetLimit>("Regex_SetLimit");
+  RegisterNative<&Script::Regex_GetTimeoutCount>("Regex_GetTimeoutCount");
+  RegisterNative<&Script::Regex_GetLastError>("Regex_GetLastError");
+
+  RegisterNative<&Script::Regex_GetStats>("Regex_GetStats");
+  RegisterNative<&Script::Regex_GetLengthHistogram>(
+      "Regex_GetLengthHistogram");
+  RegisterNative<&Script::Regex_DumpStats>("Regex_DumpStats");
+
+  RegisterNative<&Script::Regex_GetMemoryUsage>("Regex_GetMemoryUsage");
+
+  RegisterNative<&Script::RegexSet_New>("RegexSet_New");
+  RegisterNative<&Script::RegexSet_Delete>("RegexSet_Delete");
+  RegisterNative<&Script::RegexSet_Add>("RegexSet_Add");
+  RegisterNative<&Script::RegexSet_Compile>("RegexSet_Compile");
+  RegisterNative<&Script::RegexSet_Match>("RegexSet_Match");
+
+  RegisterNative<&Script::RegexStream_New>("RegexStream_New");
+  RegisterNative<&Script::RegexStream_Delete>("RegexStream_Delete");
+  RegisterNative<&Script::RegexStream_Feed>("RegexStream_Feed");
+  RegisterNative<&Script::RegexStream_Finish>("RegexStream_Finish");
+  RegisterNative<&Script::RegexStream_Next>("RegexStream_Next");
 
   RegisterNative<&Script::Match_GetGroup>("Match_GetGroup");
+  RegisterNative<&Script::Match_GetNamedGroup>("Match_GetNamedGroup");
+  RegisterNative<&Script::Match_GetGroupPos>("Match_GetGroupPos");
+  RegisterNative<&Script::Match_GetGroupCount>("Match_GetGroupCount");
   RegisterNative<&Script::Match_Free>("Match_Free");
+  RegisterNative<&Script::Match_FreeAll>("Match_FreeAll");
+  RegisterNative<&Script::Match_SetScoped>("Match_SetScoped");
+  RegisterNative<&Script::Match_GetCount>("Match_GetCount");
+
+  RegisterNative<&Script::MatchList_Count>("MatchList_Count");
+  RegisterNative<&Script::MatchList_GetGroup>("MatchList_GetGroup");
+  RegisterNative<&Script::MatchList_GetGroupPos>("MatchList_GetGroupPos");
+  RegisterNative<&Script::MatchList_Free>("MatchList_Free");
 
   Log("\n\n"
       "    | %s %s | 2016 - %s"
@@ -54,15 +111,95 @@ bool Plugin::OnLoad() {
       Name(), VersionAsString().c_str(), &__DATE__[7], __DATE__, __TIME__,
       Name());
 
+  LoadPatternBundle();
+
   return true;
 }
 
 void Plugin::OnUnload() {
+  worker_pool_.Stop();
+
+  if (Profiler::IsEnabled()) {
+    DumpProfile();
+  }
+
   SaveConfig();
 
+  Log("memory usage: %s, peak %s, %lu bytes at most",
+      memory_usage_.ToString(false).c_str(),
+      memory_usage_.ToString(true).c_str(),
+      static_cast<unsigned long>(memory_usage_.GetPeakBytes()));
+
   Log("plugin unloaded");
 }
 
+void Plugin::OnProcessTick() {
+  for (const auto script : scoped_scripts_) {
+    script->FreeScopedMatchResults();
+  }
+
+  scoped_scripts_.clear();
+
+  regex_registry_.Reclaim();
+
+  if (Profiler::IsEnabled() && profile_dump_interval_.count()) {
+    const auto now = std::chrono::steady_clock::now();
+    if (now >= next_profile_dump_) {
+      DumpProfile();
+
+      next_profile_dump_ = now + profile_dump_interval_;
+    }
+  }
+
+  std::vector<std::function<void()>> completions;
+
+  {
+    std::lock_guard<std::mutex> lock{completions_mutex_};
+
+    completions.swap(completions_);
+  }
+
+  for (const auto &completion : completions) {
+    try {
+      completion();
+    } catch (const std::exception &e) {
+      Log("%s", e.what());
+    }
+  }
+}
+
+void Plugin::PushCompletion(std::function<void()> completion) {
+  std::lock_guard<std::mutex> lock{completions_mutex_};
+
+  completions_.push_back(std::move(completion));
+}
+
+void Plugin::LoadPatternBundle() {
+  if (pattern_bundle_path_.empty() || !std::ifstream{pattern_bundle_path_}) {
+    return;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+
+  try {
+    for (const auto &error :
+         pattern_bundle_.Load(pattern_bundle_path_, worker_pool_)) {
+      Log("%s", error.c_str());
+    }
+  } catch (const std::exception &e) {
+    Log("%s: %s", pattern_bundle_path_.c_str(), e.what());
+
+    return;
+  }
+
+  const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+
+  Log("%lu patterns loaded from %s in %ld ms",
+      static_cast<unsigned long>(pattern_bundle_.Size()),
+      pattern_bundle_path_.c_str(), static_cast<long>(elapsed.count()));
+}
+
 void Plugin::ReadConfig() {
   std::fstream{config_path_, std::fstream::out | std::fstream::app};
 
@@ -70,12 +207,108 @@ void Plugin::ReadConfig() {
 
   locale_ =
       std::locale{config->get_as<std::string>("LocaleName").value_or("C")};
+
+  engine_locales_ = EngineLocales{locale_};
+
+  const static std::unordered_map<std::string, CharMode> mode_map{
+      {"locale", CharMode::kLocale},
+      {"bytes", CharMode::kBytes},
+      {"utf8", CharMode::kUtf8},
+  };
+
+  regex_mode_ = config->get_as<std::string>("RegexMode").value_or("locale");
+
+  const auto iter = mode_map.find(regex_mode_);
+  if (iter == mode_map.end()) {
+    Log("Unknown RegexMode %s, using locale", regex_mode_.c_str());
+
+    regex_mode_ = "locale";
+  }
+
+  default_char_mode_ =
+      iter == mode_map.end() ? CharMode::kLocale : iter->second;
+
+  const static std::unordered_map<std::string, RegexEngine> engine_map{
+      {"std", RegexEngine::kStd},
+      {"re2", RegexEngine::kRe2},
+  };
+
+  engine_ = config->get_as<std::string>("Engine").value_or("std");
+
+  const auto engine_iter = engine_map.find(engine_);
+  if (engine_iter == engine_map.end()) {
+    Log("Unknown Engine %s, using std", engine_.c_str());
+
+    engine_ = "std";
+  }
+
+  default_engine_ = engine_iter == engine_map.end() ? RegexEngine::kStd
+                                                    : engine_iter->second;
+
+  regex_cache_.SetCapacity(std::max<std::int64_t>(
+      config->get_as<std::int64_t>("RegexCacheSize").value_or(256), 0));
+
+  worker_threads_ = std::max<std::int64_t>(
+      config->get_as<std::int64_t>("WorkerThreads").value_or(2), 0);
+
+  batch_parallel_threshold_ = std::max<std::int64_t>(
+      config->get_as<std::int64_t>("BatchParallelThreshold").value_or(512),
+      0);
+
+  pattern_bundle_path_ = config->get_as<std::string>("PatternBundle")
+                             .value_or("plugins/pawnregex_patterns.toml");
+
+  default_match_limit_.time =
+      std::chrono::microseconds{std::max<std::int64_t>(
+          config->get_as<std::int64_t>("MatchTimeLimit").value_or(0), 0)};
+  default_match_limit_.steps = std::max<std::int64_t>(
+      config->get_as<std::int64_t>("MatchStepLimit").value_or(0), 0);
+
+  const auto get_limit = [&config](const char *key) {
+    return static_cast<std::size_t>(std::max<std::int64_t>(
+        config->get_as<std::int64_t>(key).value_or(0), 0));
+  };
+
+  memory_limits_.regexes = get_limit("MaxRegexes");
+  memory_limits_.matches = get_limit("MaxMatches");
+  memory_limits_.bytes = get_limit("MaxMemory");
+  memory_limits_.total_bytes = get_limit("MaxTotalMemory");
+
+  Profiler::SetEnabled(config->get_as<bool>("Profiling").value_or(false));
+
+  profile_dump_interval_ = std::chrono::seconds{std::max<std::int64_t>(
+      config->get_as<std::int64_t>("ProfileDumpInterval").value_or(60), 0)};
+
+  next_profile_dump_ =
+      std::chrono::steady_clock::now() + profile_dump_interval_;
 }
 
 void Plugin::SaveConfig() {
   auto config = cpptoml::make_table();
 
   config->insert("LocaleName", locale_.name());
+  config->insert("RegexMode", regex_mode_);
+  config->insert("Engine", engine_);
+  config->insert("RegexCacheSize",
+                 static_cast<std::int64_t>(regex_cache_.GetCapacity()));
+  config->insert("WorkerThreads", static_cast<std::int64_t>(worker_threads_));
+  config->insert("BatchParallelThreshold",
+                 static_cast<std::int64_t>(batch_parallel_threshold_));
+  config->insert("PatternBundle", pattern_bundle_path_);
+  config->insert("MatchTimeLimit", static_cast<std::int64_t>(
+                                       default_match_limit_.time.count()));
+  config->insert("MatchStepLimit",
+                 static_cast<std::int64_t>(default_match_limit_.steps));
+  config->insert("MaxRegexes",
+                 static_cast<std::int64_t>(memory_limits_.regexes));
+  config->insert("MaxMatches",
+                 static_cast<std::int64_t>(memory_limits_.matches));
+  config->insert("MaxMemory", static_cast<std::int64_t>(memory_limits_.bytes));
+  config->insert("MaxTotalMemory",
+                 static_cast<std::int64_t>(memory_limits_.total_bytes));
+  config->insert("Profiling", Profiler::IsEnabled());
+  config->insert("ProfileDumpInterval",
+                 static_cast<std::int64_t>(profile_dump_interval_.count()));
 
   std::fstream{config_path_, std::fstream::out | std::fstream::trunc}
       << (*config);
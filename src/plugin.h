@@ -35,16 +35,95 @@ class Plugin : public ptl::AbstractPlugin<Plugin, Script, NativeParam> {
 
   void OnUnload();
 
+  void OnProcessTick();
+
   void ReadConfig();
 
+  void LoadPatternBundle();
+
   void SaveConfig();
 
-  const std::locale &GetLocale() const { return locale_; }
+  const EngineLocales &GetEngineLocales() const { return engine_locales_; }
+
+  // Mode of patterns compiled without REGEX_LOCALE, REGEX_BYTES or REGEX_UTF8
+  CharMode GetDefaultCharMode() const { return default_char_mode_; }
+
+  // Engine of patterns compiled without REGEX_STD or REGEX_RE2
+  RegexEngine GetDefaultEngine() const { return default_engine_; }
+
+  // Limit of new regex handles, see Regex_SetLimit
+  const MatchLimit &GetDefaultMatchLimit() const {
+    return default_match_limit_;
+  }
+
+  RegexCache &GetRegexCache() { return regex_cache_; }
+
+  RegexRegistry &GetRegexRegistry() { return regex_registry_; }
+
+  WorkerPool &GetWorkerPool() { return worker_pool_; }
+
+  PatternBundle &GetPatternBundle() { return pattern_bundle_; }
+
+  // Batches with more rows than this are split across the worker threads,
+  // see Regex_CheckMany. 0 keeps them on the main thread.
+  std::size_t GetBatchParallelThreshold() const {
+    return batch_parallel_threshold_;
+  }
+
+  Profiler &GetProfiler() { return profiler_; }
+
+  // Handles of all scripts, see Regex_GetMemoryUsage
+  MemoryUsage &GetMemoryUsage() { return memory_usage_; }
+
+  const MemoryLimits &GetMemoryLimits() const { return memory_limits_; }
+
+  void SetMemoryLimits(const MemoryLimits &limits) { memory_limits_ = limits; }
+
+  void DumpProfile() { profiler_.Dump(profile_path_); }
+
+  // Queues a function to be run on the main thread in the next ProcessTick
+  void PushCompletion(std::function<void()> completion);
+
+  void AddScopedScript(Script *script) { scoped_scripts_.insert(script); }
+
+  void RemoveScopedScript(Script *script) { scoped_scripts_.erase(script); }
 
  private:
   const std::string config_path_ = "plugins/pawnregex.cfg";
+  const std::string profile_path_ = "plugins/pawnregex_profile.toml";
 
   std::locale locale_;
+  EngineLocales engine_locales_;
+  std::string regex_mode_;
+  CharMode default_char_mode_{};
+  std::string engine_;
+  RegexEngine default_engine_{};
+
+  MatchLimit default_match_limit_;
+
+  MemoryUsage memory_usage_;
+  MemoryLimits memory_limits_;
+
+  RegexCache regex_cache_;
+
+  RegexRegistry regex_registry_;
+
+  WorkerPool worker_pool_;
+  std::size_t worker_threads_{};
+  std::size_t batch_parallel_threshold_{};
+
+  PatternBundle pattern_bundle_;
+  std::string pattern_bundle_path_;
+
+  Profiler profiler_;
+  std::chrono::seconds profile_dump_interval_{};
+  std::chrono::steady_clock::time_point next_profile_dump_;
+
+  std::mutex completions_mutex_;
+  std::vector<std::function<void()>> completions_;
+
+  // Scripts holding scoped matches that are freed at the end of the tick
+  std::unordered_set<Script *> scoped_scripts_;
 };
 
 #endif  // PAWNREGEX_PLUGIN_H_
@@ -0,0 +1,145 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "main.h"
+
+std::atomic<bool> Profiler::enabled_{};
+
+void CallStats::Record(std::chrono::nanoseconds time, std::size_t length,
+                       MatchOutcome outcome) {
+  constexpr auto kRelaxed = std::memory_order_relaxed;
+
+  const auto ns = static_cast<std::uint64_t>(time.count());
+
+  calls_.fetch_add(1, kRelaxed);
+  total_ns_.fetch_add(ns, kRelaxed);
+
+  if (outcome == MatchOutcome::kMatch) {
+    matches_.fetch_add(1, kRelaxed);
+  } else if (outcome == MatchOutcome::kMiss) {
+    misses_.fetch_add(1, kRelaxed);
+  }
+
+  auto max = max_ns_.load(kRelaxed);
+  while (ns > max && !max_ns_.compare_exchange_weak(max, ns, kRelaxed)) {
+  }
+
+  std::size_t bucket{};
+  for (std::size_t limit = 16; bucket + 1 < kLengthBuckets && length >= limit;
+       limit *= 4) {
+    ++bucket;
+  }
+
+  lengths_[bucket].fetch_add(1, kRelaxed);
+}
+
+void Profiler::AddRegex(const std::shared_ptr<Regex> &regex) {
+  if (regexes_.size() >= purge_threshold_) {
+    Purge();
+
+    purge_threshold_ = std::max<std::size_t>(regexes_.size() * 2, 64);
+  }
+
+  regexes_.push_back(regex);
+}
+
+void Profiler::Dump(const std::string &path) {
+  Purge();
+
+  const auto root = cpptoml::make_table();
+
+  const auto ops = cpptoml::make_table();
+
+  const static std::array<const char *, static_cast<std::size_t>(
+                                            RegexOp::kCount)>
+      op_names{"match", "search", "search_all", "replace"};
+
+  for (std::size_t op{}; op < op_stats_.size(); ++op) {
+    ops->insert(op_names[op], MakeStatsTable(op_stats_[op]));
+  }
+
+  root->insert("operations", ops);
+
+  const auto patterns = cpptoml::make_table_array();
+
+  for (const auto &weak_regex : regexes_) {
+    const auto regex = weak_regex.lock();
+    if (!regex) {
+      continue;
+    }
+
+    const auto table = MakeStatsTable(regex->GetStats());
+
+    table->insert("pattern", regex->GetPattern());
+    table->insert("compile_us",
+                  static_cast<std::int64_t>(
+                      std::chrono::duration_cast<std::chrono::microseconds>(
+                          regex->GetCompileTime())
+                          .count()));
+    table->insert("timeouts",
+                  static_cast<std::int64_t>(regex->GetTimeoutCount()));
+
+    patterns->push_back(table);
+  }
+
+  root->insert("patterns", patterns);
+
+  std::fstream{path, std::fstream::out | std::fstream::trunc} << (*root);
+}
+
+std::shared_ptr<cpptoml::table> Profiler::MakeStatsTable(
+    const CallStats &stats) {
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+
+  const auto table = cpptoml::make_table();
+
+  table->insert("calls", static_cast<std::int64_t>(stats.GetCalls()));
+  table->insert("matches", static_cast<std::int64_t>(stats.GetMatches()));
+  table->insert("misses", static_cast<std::int64_t>(stats.GetMisses()));
+  table->insert("total_us",
+                static_cast<std::int64_t>(
+                    duration_cast<microseconds>(stats.GetTotalTime()).count()));
+  table->insert("max_us",
+                static_cast<std::int64_t>(
+                    duration_cast<microseconds>(stats.GetMaxTime()).count()));
+
+  const auto lengths = cpptoml::make_array();
+
+  for (std::size_t bucket{}; bucket < CallStats::kLengthBuckets; ++bucket) {
+    lengths->push_back(static_cast<std::int64_t>(stats.GetLengthCount(bucket)));
+  }
+
+  table->insert("lengths", lengths);
+
+  return table;
+}
+
+void Profiler::Purge() {
+  regexes_.erase(std::remove_if(regexes_.begin(), regexes_.end(),
+                                [](const std::weak_ptr<Regex> &regex) {
+                                  return regex.expired();
+                                }),
+                 regexes_.end());
+}
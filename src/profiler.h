@@ -0,0 +1,113 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PAWNREGEX_PROFILER_H_
+#define PAWNREGEX_PROFILER_H_
+
+class Regex;
+
+// Kind of work done by a matching native
+enum class RegexOp {
+  kMatch,      // Regex_Check, Regex_Match
+  kSearch,     // Regex_Search, Regex_SearchAsync, RegexSet_Match
+  kSearchAll,  // Regex_SearchAll, Regex_SearchAllPos
+  kReplace,    // Regex_Replace, Regex_ReplaceAsync
+  kCount
+};
+
+enum class MatchOutcome { kNone, kMiss, kMatch };
+
+// Counters for one pattern or one kind of work. They are updated from the
+// main thread and the worker threads, so every field is a relaxed atomic.
+class CallStats {
+ public:
+  // Inputs shorter than 16, 64, 256, 1024 characters and the rest
+  static constexpr std::size_t kLengthBuckets = 5;
+
+  void Record(std::chrono::nanoseconds time, std::size_t length,
+              MatchOutcome outcome);
+
+  std::uint64_t GetCalls() const { return Load(calls_); }
+
+  std::uint64_t GetMatches() const { return Load(matches_); }
+
+  std::uint64_t GetMisses() const { return Load(misses_); }
+
+  std::chrono::nanoseconds GetTotalTime() const {
+    return std::chrono::nanoseconds{Load(total_ns_)};
+  }
+
+  std::chrono::nanoseconds GetMaxTime() const {
+    return std::chrono::nanoseconds{Load(max_ns_)};
+  }
+
+  std::uint64_t GetLengthCount(std::size_t bucket) const {
+    return Load(lengths_.at(bucket));
+  }
+
+ private:
+  static std::uint64_t Load(const std::atomic<std::uint64_t> &value) {
+    return value.load(std::memory_order_relaxed);
+  }
+
+  std::atomic<std::uint64_t> calls_{};
+  std::atomic<std::uint64_t> matches_{};
+  std::atomic<std::uint64_t> misses_{};
+  std::atomic<std::uint64_t> total_ns_{};
+  std::atomic<std::uint64_t> max_ns_{};
+  std::array<std::atomic<std::uint64_t>, kLengthBuckets> lengths_{};
+};
+
+// Optional instrumentation of the matching natives. While it is disabled the
+// only cost on the hot path is the IsEnabled check in Regex.
+class Profiler {
+ public:
+  static bool IsEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  static void SetEnabled(bool enabled) { enabled_ = enabled; }
+
+  // Remembers a newly compiled pattern so that it shows up in the dump
+  void AddRegex(const std::shared_ptr<Regex> &regex);
+
+  CallStats &GetOpStats(RegexOp op) {
+    return op_stats_.at(static_cast<std::size_t>(op));
+  }
+
+  // Writes the statistics of every live pattern to path as TOML
+  void Dump(const std::string &path);
+
+ private:
+  static std::shared_ptr<cpptoml::table> MakeStatsTable(
+      const CallStats &stats);
+
+  void Purge();
+
+  static std::atomic<bool> enabled_;
+
+  std::array<CallStats, static_cast<std::size_t>(RegexOp::kCount)> op_stats_;
+  std::vector<std::weak_ptr<Regex>> regexes_;
+  std::size_t purge_threshold_{64};
+};
+
+#endif  // PAWNREGEX_PROFILER_H_
@@ -0,0 +1,183 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "main.h"
+
+Regex::Regex(const std::string &pattern,
+             std::regex_constants::syntax_option_type option, CharMode mode,
+             RegexEngine engine, const EngineLocales &locales)
+    : pattern_{pattern},
+      mode_{mode},
+      engine_{engine},
+      icase_{(option & std::regex_constants::icase) != 0},
+      group_names_{std::make_shared<GroupNames>(pattern, option)},
+      info_{group_names_->GetPattern(), option, mode} {
+  // RE2 programs take about this many bytes per instruction. The DFA cache
+  // grows on use and is left out.
+  constexpr std::size_t kRe2InstructionSize = 16;
+
+  constexpr auto kOtherGrammars =
+      std::regex_constants::basic | std::regex_constants::extended |
+      std::regex_constants::awk | std::regex_constants::grep |
+      std::regex_constants::egrep;
+
+  const auto &locale = locales.Get(mode_, icase_);
+
+  const auto start = std::chrono::steady_clock::now();
+
+  std::size_t engine_size{};
+
+  if (engine_ == RegexEngine::kRe2) {
+    if (option & kOtherGrammars) {
+      throw std::runtime_error{"RE2 only reads the ECMAScript grammar"};
+    }
+
+    // Bytes are Latin-1 characters to RE2, whatever the locale says
+    re2::RE2::Options options;
+    options.set_encoding(mode_ == CharMode::kUtf8
+                             ? re2::RE2::Options::EncodingUTF8
+                             : re2::RE2::Options::EncodingLatin1);
+    options.set_case_sensitive(!icase_);
+    options.set_never_capture((option & std::regex_constants::nosubs) != 0);
+    options.set_log_errors(false);
+
+    re2_ = std::make_unique<re2::RE2>(group_names_->GetPattern(), options);
+    if (!re2_->ok()) {
+      throw std::runtime_error{re2_->error()};
+    }
+
+    engine_size =
+        sizeof(re2::RE2) + re2_->ProgramSize() * kRe2InstructionSize;
+  } else if (mode_ == CharMode::kUtf8) {
+    wide_regex_.imbue(locale);
+    wide_regex_.assign(DecodeUtf8(group_names_->GetPattern()), option);
+  } else {
+    regex_.imbue(locale);
+    regex_.assign(group_names_->GetPattern(), option);
+  }
+
+  compile_time_ = std::chrono::steady_clock::now() - start;
+
+  if (!re2_) {
+    engine_size = PatternInfo::EstimateEngineSize(pattern_, mode_);
+  }
+
+  memory_size_ = sizeof(*this) + pattern_.capacity() +
+                 info_.GetRequiredLiteral().capacity() +
+                 info_.GetLiteralPrefix().capacity() + engine_size;
+
+  for (const auto &literal : info_.GetAlternativeLiterals()) {
+    memory_size_ += sizeof(literal) + literal.capacity();
+  }
+
+  // Matches only carry the table around when there is something in it
+  if (group_names_->IsEmpty()) {
+    group_names_.reset();
+  }
+}
+
+bool Regex::MayMatch(const char *first, const char *last) const {
+  if (static_cast<std::size_t>(last - first) < info_.GetMinLength()) {
+    return false;
+  }
+
+  const auto &literal = info_.GetRequiredLiteral();
+
+  return literal.empty() ||
+         FindLiteral(first, last, literal, IsCaseInsensitive()) != last;
+}
+
+bool Regex::MayMatchWhole(const char *first, const char *last) const {
+  const auto &prefix = info_.GetLiteralPrefix();
+  if (static_cast<std::size_t>(last - first) < prefix.size() ||
+      FindLiteral(first, first + prefix.size(), prefix, IsCaseInsensitive()) !=
+          first) {
+    return false;
+  }
+
+  if (info_.IsLiteral()) {
+    return static_cast<std::size_t>(last - first) == prefix.size();
+  }
+
+  return MayMatch(first, last);
+}
+
+bool Regex::FindRe2(const char *first, const char *last, const char *floor,
+                    std::regex_constants::match_flag_type flags, bool whole,
+                    SubjectMatch *results) const {
+  using namespace std::regex_constants;
+
+  if (flags & (match_not_bol | match_not_eol | match_not_bow | match_not_eow |
+               match_not_null)) {
+    throw std::runtime_error{
+        "RE2 does not support MATCH_NOT_BOL, MATCH_NOT_EOL, MATCH_NOT_BOW, "
+        "MATCH_NOT_EOW and MATCH_NOT_NULL"};
+  }
+
+  auto context = first;
+  if (flags & match_prev_avail) {
+    context = floor ? floor : first - 1;
+  }
+
+  auto anchor = re2::RE2::UNANCHORED;
+  if (whole) {
+    anchor = re2::RE2::ANCHOR_BOTH;
+  } else if (flags & match_continuous) {
+    anchor = re2::RE2::ANCHOR_START;
+  }
+
+  std::vector<re2::StringPiece> groups(results ? GetGroupCount() : 0);
+
+  if (!re2_->Match({context, static_cast<std::size_t>(last - context)},
+                   first - context, last - context, anchor, groups.data(),
+                   static_cast<int>(groups.size()))) {
+    return false;
+  }
+
+  if (results) {
+    results->Assign(groups.data(), groups.size(), last);
+  }
+
+  return true;
+}
+
+std::size_t Regex::GetCharLength(const char *first, const char *last) const {
+  if (mode_ != CharMode::kUtf8) {
+    return 1;
+  }
+
+  wchar_t code{};
+
+  return DecodeUtf8(first, last, code);
+}
+
+void Regex::Record(RegexOp op, std::chrono::steady_clock::time_point start,
+                   std::size_t length, MatchOutcome outcome) const {
+  const auto time = std::chrono::steady_clock::now() - start;
+
+  stats_.Record(time, length, outcome);
+
+  Plugin::Instance().GetProfiler().GetOpStats(op).Record(time, length,
+                                                         outcome);
+}
@@ -0,0 +1,580 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PAWNREGEX_REGEX_H_
+#define PAWNREGEX_REGEX_H_
+
+// Which library matches a pattern, see REGEX_STD and REGEX_RE2
+enum class RegexEngine {
+  kStd,  // std::regex, backtracking, every grammar and match flag
+  kRe2,  // RE2, linear time, no backreferences or lookarounds
+};
+
+// Compiled pattern as seen by the natives, the only place that touches the
+// matching engines. std::regex calls run under the MatchLimit they are given,
+// after the PatternInfo checks. RE2 needs no limit.
+class Regex {
+ public:
+  Regex(const std::string &pattern,
+        std::regex_constants::syntax_option_type option, CharMode mode,
+        RegexEngine engine, const EngineLocales &locales);
+
+  bool Match(const char *first, const char *last,
+             std::regex_constants::match_flag_type flags,
+             const MatchLimit &limit) const {
+    if (re2_) {
+      return Profile(RegexOp::kMatch, first, last, [&] {
+        return MayMatchWhole(first, last) &&
+               (info_.IsLiteral() ||
+                FindRe2(first, last, nullptr, flags, true, nullptr));
+      });
+    }
+
+    return Run(RegexOp::kMatch, first, last, limit,
+               [this, flags](auto first, auto last, const auto &engine) {
+                 if (!MayMatchWhole(first.base(), last.base())) {
+                   return false;
+                 }
+
+                 if (info_.IsLiteral()) {
+                   return true;
+                 }
+
+                 return std::regex_match(first, last, engine, flags);
+               });
+  }
+
+  bool Match(const char *first, const char *last, SubjectMatch &results,
+             std::regex_constants::match_flag_type flags,
+             const MatchLimit &limit) const {
+    if (re2_) {
+      return Profile(RegexOp::kMatch, first, last, [&] {
+        return MayMatchWhole(first, last) &&
+               FindRe2(first, last, nullptr, flags, true, &results);
+      });
+    }
+
+    return Run(RegexOp::kMatch, first, last, limit,
+               [this, &results, flags](auto first, auto last,
+                                       const auto &engine) {
+                 if (!MayMatchWhole(first.base(), last.base())) {
+                   return false;
+                 }
+
+                 std::match_results<decltype(first)> engine_results;
+                 if (!std::regex_match(first, last, engine_results, engine,
+                                       flags)) {
+                   return false;
+                 }
+
+                 results.Assign(engine_results);
+
+                 return true;
+               });
+  }
+
+  // With match_prev_avail, floor is where the whole subject begins, so the
+  // character before first can be read even if it takes several bytes
+  bool Search(const char *first, const char *last, SubjectMatch &results,
+              std::regex_constants::match_flag_type flags,
+              const MatchLimit &limit, const char *floor = nullptr) const {
+    if (re2_) {
+      return Profile(RegexOp::kSearch, first, last, [&] {
+        return MayMatch(first, last) &&
+               FindRe2(first, last, floor, flags, false, &results);
+      });
+    }
+
+    return Run(
+        RegexOp::kSearch, first, last, limit,
+        [this, &results, flags](auto first, auto last, const auto &engine) {
+          if (!MayMatch(first.base(), last.base())) {
+            return false;
+          }
+
+          std::match_results<decltype(first)> engine_results;
+          if (!SearchCandidates(first, last, engine_results, engine, flags)) {
+            return false;
+          }
+
+          results.Assign(engine_results);
+
+          return true;
+        },
+        floor);
+  }
+
+  template <typename Func>
+  void SearchAll(const char *first, const char *last,
+                 std::regex_constants::match_flag_type flags,
+                 const MatchLimit &limit, Func on_match) const {
+    if (re2_) {
+      Profile(RegexOp::kSearchAll, first, last, [&] {
+        return MayMatch(first, last) &&
+               ForEachRe2(first, last, flags, [&on_match](const auto &results) {
+                 on_match(results);
+
+                 return true;
+               });
+      });
+
+      return;
+    }
+
+    Run(RegexOp::kSearchAll, first, last, limit,
+        [this, flags, &on_match](auto first, auto last, const auto &engine) {
+          using Iterator = decltype(first);
+
+          if (!MayMatch(first.base(), last.base())) {
+            return false;
+          }
+
+          SubjectMatch results;
+
+          // Matches of these patterns are never empty after the first one,
+          // so the next search simply starts where the last match ended
+          if (info_.IsAnchoredStart() || !info_.GetLiteralPrefix().empty()) {
+            std::match_results<Iterator> engine_results;
+            bool found{};
+
+            auto search_flags = flags;
+            while (SearchCandidates(first, last, engine_results, engine,
+                                    search_flags)) {
+              results.Assign(engine_results);
+
+              on_match(results);
+
+              found = true;
+
+              first = engine_results[0].second;
+
+              search_flags = flags | std::regex_constants::match_prev_avail;
+            }
+
+            return found;
+          }
+
+          const EngineIterator<Iterator, decltype(engine)> end;
+
+          EngineIterator<Iterator, decltype(engine)> iter{first, last, engine,
+                                                          flags};
+          const bool found = iter != end;
+
+          for (; iter != end; ++iter) {
+            results.Assign(*iter);
+
+            on_match(results);
+          }
+
+          return found;
+        });
+  }
+
+  // std::regex_replace into out, returns the number of replacements
+  template <typename OutputIt>
+  std::size_t Replace(OutputIt out, const char *first, const char *last,
+                      std::string_view fmt,
+                      std::regex_constants::match_flag_type flags,
+                      const MatchLimit &limit) const {
+    if (re2_) {
+      return Profile(RegexOp::kReplace, first, last, [&] {
+        return ReplaceEach(out, first, last, fmt, flags, [&](auto on_match) {
+          ForEachRe2(first, last, flags, on_match);
+        });
+      });
+    }
+
+    return Run(
+        RegexOp::kReplace, first, last, limit,
+        [this, out, fmt, flags](auto first, auto last, const auto &engine) {
+          using Iterator = EngineIterator<decltype(first), decltype(engine)>;
+
+          return ReplaceEach(
+              out, first.base(), last.base(), fmt, flags, [&](auto on_match) {
+                SubjectMatch results;
+
+                const Iterator end;
+
+                for (Iterator iter{first, last, engine, flags}; iter != end;
+                     ++iter) {
+                  results.Assign(*iter);
+
+                  if (!on_match(results)) {
+                    break;
+                  }
+                }
+              });
+        });
+  }
+
+  const std::string &GetPattern() const { return pattern_; }
+
+  CharMode GetCharMode() const { return mode_; }
+
+  RegexEngine GetEngine() const { return engine_; }
+
+  const PatternInfo &GetInfo() const { return info_; }
+
+  std::size_t GetGroupCount() const {
+    if (re2_) {
+      return re2_->NumberOfCapturingGroups() + 1;
+    }
+
+    return (mode_ == CharMode::kUtf8 ? wide_regex_.mark_count()
+                                     : regex_.mark_count()) +
+           1;
+  }
+
+  // nullptr if the pattern has no named groups
+  const GroupNamesPtr &GetGroupNames() const { return group_names_; }
+
+  // Returns -1 if there is no group with this name
+  int GetGroupIndex(std::string_view name) const {
+    return group_names_ ? group_names_->Find(name) : -1;
+  }
+
+  std::size_t GetTimeoutCount() const { return timeouts_; }
+
+  const CallStats &GetStats() const { return stats_; }
+
+  std::chrono::nanoseconds GetCompileTime() const { return compile_time_; }
+
+  // Estimated bytes held by the compiled pattern, see Regex_GetMemoryUsage
+  std::size_t GetMemorySize() const { return memory_size_; }
+
+ private:
+  using NarrowRegex = std::basic_regex<char, RegexTraits<char>>;
+  using WideRegex = std::basic_regex<wchar_t, RegexTraits<wchar_t>>;
+
+  template <typename Iterator, typename Engine>
+  using EngineIterator =
+      std::regex_iterator<Iterator, typename std::decay_t<Engine>::value_type,
+                          typename std::decay_t<Engine>::traits_type>;
+
+  // Calls func(first, last, engine) with the iterators and the engine of the
+  // pattern's CharMode
+  template <typename Func>
+  std::invoke_result_t<Func, SubjectIterator, SubjectIterator,
+                       const NarrowRegex &>
+  Run(RegexOp op, const char *first, const char *last,
+      const MatchLimit &limit, Func func, const char *floor = nullptr) const {
+    return Profile(op, first, last, [&] {
+      return RunLimited(first, last, floor, limit, func);
+    });
+  }
+
+  // Calls body() and records the call in the profiler
+  template <typename Body>
+  std::invoke_result_t<Body> Profile(RegexOp op, const char *first,
+                                     const char *last, Body body) const {
+    if (!Profiler::IsEnabled()) {
+      return body();
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    try {
+      auto result = body();
+
+      if constexpr (std::is_same_v<decltype(result), bool>) {
+        Record(op, start, last - first,
+               result ? MatchOutcome::kMatch : MatchOutcome::kMiss);
+      } else {
+        Record(op, start, last - first, MatchOutcome::kNone);
+      }
+
+      return result;
+    } catch (const MatchTimeout &) {
+      Record(op, start, last - first, MatchOutcome::kNone);
+
+      throw;
+    }
+  }
+
+  template <typename Func>
+  std::invoke_result_t<Func, SubjectIterator, SubjectIterator,
+                       const NarrowRegex &>
+  RunLimited(const char *first, const char *last, const char *floor,
+             const MatchLimit &limit, Func &func) const {
+    MatchBudget budget{limit};
+
+    try {
+      if (mode_ == CharMode::kUtf8) {
+        if (!floor) {
+          floor = first;
+        }
+
+        return func(Utf8SubjectIterator{first, floor, last, &budget},
+                    Utf8SubjectIterator{last, floor, last, &budget},
+                    wide_regex_);
+      }
+
+      return func(SubjectIterator{first, &budget},
+                  SubjectIterator{last, &budget}, regex_);
+    } catch (const MatchTimeout &e) {
+      ++timeouts_;
+
+      throw MatchTimeout{std::string{e.what()} + " in pattern " + pattern_};
+    }
+  }
+
+  // Copies [first, last) into out with every match for_each(on_match) passes
+  // to on_match replaced by fmt. on_match returns false when for_each should
+  // stop.
+  template <typename OutputIt, typename ForEach>
+  std::size_t ReplaceEach(OutputIt out, const char *first, const char *last,
+                          std::string_view fmt,
+                          std::regex_constants::match_flag_type flags,
+                          ForEach for_each) const {
+    const bool copy = !(flags & std::regex_constants::format_no_copy);
+
+    std::size_t count{};
+    auto tail = first;
+
+    if (MayMatch(first, last)) {
+      for_each([&](const SubjectMatch &results) {
+        if (copy) {
+          out = std::copy(tail, results[0].first, out);
+        }
+
+        out = Format(out, fmt, results, tail, last, flags);
+
+        tail = results[0].second;
+
+        ++count;
+
+        return !(flags & std::regex_constants::format_first_only);
+      });
+    }
+
+    if (copy) {
+      std::copy(tail, last, out);
+    }
+
+    return count;
+  }
+
+  // One RE2 match in [first, last), the whole of it if whole is set. With
+  // match_prev_avail, "^" and "\b" see the text from floor on, or the byte
+  // before first. results may be nullptr.
+  bool FindRe2(const char *first, const char *last, const char *floor,
+               std::regex_constants::match_flag_type flags, bool whole,
+               SubjectMatch *results) const;
+
+  // Calls on_match for every RE2 match until it returns false. An empty
+  // match is followed by a search from the next character.
+  template <typename Func>
+  bool ForEachRe2(const char *first, const char *last,
+                  std::regex_constants::match_flag_type flags,
+                  Func on_match) const {
+    using namespace std::regex_constants;
+
+    const auto floor = flags & match_prev_avail ? first - 1 : first;
+
+    SubjectMatch results;
+    bool found{};
+
+    auto pos = first;
+    while (FindRe2(pos, last, floor, flags | match_prev_avail, false,
+                   &results)) {
+      found = true;
+
+      if (!on_match(results)) {
+        break;
+      }
+
+      pos = results[0].second;
+
+      if (results[0].first == pos) {
+        if (pos == last) {
+          break;
+        }
+
+        pos += GetCharLength(pos, last);
+      }
+    }
+
+    return found;
+  }
+
+  // Bytes of the character at first
+  std::size_t GetCharLength(const char *first, const char *last) const;
+
+  // std::match_results::format, with the prefix starting at prefix and the
+  // suffix ending at suffix_last
+  template <typename OutputIt>
+  static OutputIt Format(OutputIt out, std::string_view fmt,
+                         const SubjectMatch &results, const char *prefix,
+                         const char *suffix_last,
+                         std::regex_constants::match_flag_type flags) {
+    const auto group = [&out, &results](std::size_t index) {
+      if (index < results.size() && results[index].matched) {
+        out = std::copy(results[index].first, results[index].second, out);
+      }
+    };
+
+    const auto is_digit = [](char ch) { return ch >= '0' && ch <= '9'; };
+
+    if (flags & std::regex_constants::format_sed) {
+      for (std::size_t i{}; i < fmt.size(); ++i) {
+        if (fmt[i] == '&') {
+          group(0);
+        } else if (fmt[i] == '\\' && i + 1 < fmt.size()) {
+          const auto escaped = fmt[++i];
+
+          if (is_digit(escaped)) {
+            group(escaped - '0');
+          } else {
+            *out++ = escaped;
+          }
+        } else {
+          *out++ = fmt[i];
+        }
+      }
+
+      return out;
+    }
+
+    std::size_t i{};
+
+    for (auto dollar = fmt.find('$'); dollar != std::string_view::npos;
+         dollar = fmt.find('$', i)) {
+      out = std::copy(fmt.data() + i, fmt.data() + dollar, out);
+
+      i = dollar + 1;
+
+      const auto ch = i < fmt.size() ? fmt[i] : '\0';
+
+      if (ch == '&') {
+        group(0);
+      } else if (ch == '`') {
+        out = std::copy(prefix, results[0].first, out);
+      } else if (ch == '\'') {
+        out = std::copy(results[0].second, suffix_last, out);
+      } else if (is_digit(ch)) {
+        std::size_t index = ch - '0';
+
+        if (i + 1 < fmt.size() && is_digit(fmt[i + 1])) {
+          index = index * 10 + (fmt[++i] - '0');
+        }
+
+        group(index);
+      } else {
+        // "$$" and a "$" that is not followed by anything it knows
+        *out++ = '$';
+
+        if (ch != '$') {
+          continue;
+        }
+      }
+
+      ++i;
+    }
+
+    return std::copy(fmt.data() + i, fmt.data() + fmt.size(), out);
+  }
+
+  bool IsCaseInsensitive() const { return icase_; }
+
+  // Whether a subject or its part may contain a match
+  bool MayMatch(const char *first, const char *last) const;
+
+  // Whether a subject may match the pattern as a whole
+  bool MayMatchWhole(const char *first, const char *last) const;
+
+  template <typename Iterator, typename Engine>
+  bool SearchCandidates(Iterator first, Iterator last,
+                        std::match_results<Iterator> &results,
+                        const Engine &engine,
+                        std::regex_constants::match_flag_type flags) const {
+    using namespace std::regex_constants;
+
+    // Without the multiline option "^" only matches at the very beginning
+    if (info_.IsAnchoredStart()) {
+      if (flags & (match_not_bol | match_prev_avail)) {
+        return false;
+      }
+
+      return std::regex_search(first, last, results, engine,
+                               flags | match_continuous);
+    }
+
+    const auto &prefix = info_.GetLiteralPrefix();
+    if (prefix.empty() || (flags & match_continuous)) {
+      return std::regex_search(first, last, results, engine, flags);
+    }
+
+    for (auto candidate = first.base();; ++candidate) {
+      candidate =
+          FindLiteral(candidate, last.base(), prefix, IsCaseInsensitive());
+      if (candidate == last.base()) {
+        return false;
+      }
+
+      auto candidate_flags = flags | match_continuous;
+      if (candidate != first.base()) {
+        candidate_flags |= match_prev_avail;
+      }
+
+      if (std::regex_search(first.At(candidate), last, results, engine,
+                            candidate_flags)) {
+        return true;
+      }
+    }
+  }
+
+  void Record(RegexOp op, std::chrono::steady_clock::time_point start,
+              std::size_t length, MatchOutcome outcome) const;
+
+  std::string pattern_;
+  CharMode mode_{};
+  RegexEngine engine_{};
+  bool icase_{};
+  GroupNamesPtr group_names_;
+  NarrowRegex regex_;
+  WideRegex wide_regex_;
+  std::unique_ptr<re2::RE2> re2_;
+  PatternInfo info_;
+  std::chrono::nanoseconds compile_time_{};
+  std::size_t memory_size_{};
+  mutable CallStats stats_;
+  mutable std::atomic<std::size_t> timeouts_{};
+};
+
+using RegexPtr = std::shared_ptr<Regex>;
+
+// What a regex handle refers to: the shared pattern and the limit of the
+// handle, see Regex_SetLimit
+struct RegexRef {
+  const Regex &operator*() const { return *regex; }
+
+  const Regex *operator->() const { return regex.get(); }
+
+  explicit operator bool() const { return regex != nullptr; }
+
+  RegexPtr regex;
+  MatchLimit limit;
+};
+
+#endif  // PAWNREGEX_REGEX_H_
@@ -0,0 +1,109 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "main.h"
+
+RegexPtr RegexCache::Get(std::string_view pattern,
+                         std::regex_constants::syntax_option_type option,
+                         CharMode mode, RegexEngine engine) {
+  SetKey(pattern, option, mode, engine);
+
+  const auto iter = index_.find(key_);
+  if (iter != index_.end()) {
+    ++hits_;
+
+    entries_.splice(entries_.begin(), entries_, iter->second);
+
+    return iter->second->second;
+  }
+
+  ++misses_;
+
+  auto &plugin = Plugin::Instance();
+
+  const auto regex = std::make_shared<Regex>(
+      std::string{pattern}, option, mode, engine, plugin.GetEngineLocales());
+
+  if (Profiler::IsEnabled()) {
+    plugin.GetProfiler().AddRegex(regex);
+  }
+
+  if (capacity_) {
+    Evict(capacity_ - 1);
+
+    entries_.emplace_front(key_, regex);
+
+    index_.emplace(entries_.front().first, entries_.begin());
+  }
+
+  return regex;
+}
+
+void RegexCache::Add(std::string_view pattern,
+                     std::regex_constants::syntax_option_type option,
+                     CharMode mode, RegexEngine engine, RegexPtr regex) {
+  SetKey(pattern, option, mode, engine);
+
+  const auto iter = index_.find(key_);
+  if (iter != index_.end()) {
+    iter->second->second = std::move(regex);
+
+    entries_.splice(entries_.begin(), entries_, iter->second);
+
+    return;
+  }
+
+  if (capacity_) {
+    Evict(capacity_ - 1);
+
+    entries_.emplace_front(key_, std::move(regex));
+
+    index_.emplace(entries_.front().first, entries_.begin());
+  }
+}
+
+void RegexCache::SetCapacity(std::size_t capacity) {
+  capacity_ = capacity;
+
+  Evict(capacity_);
+}
+
+void RegexCache::SetKey(std::string_view pattern,
+                        std::regex_constants::syntax_option_type option,
+                        CharMode mode, RegexEngine engine) {
+  key_.assign(reinterpret_cast<const char *>(&option), sizeof(option));
+  key_.push_back(static_cast<char>(mode));
+  key_.push_back(static_cast<char>(engine));
+  key_.append(pattern);
+}
+
+void RegexCache::Evict(std::size_t capacity) {
+  while (entries_.size() > capacity) {
+    index_.erase(entries_.back().first);
+
+    entries_.pop_back();
+
+    ++evictions_;
+  }
+}
@@ -0,0 +1,68 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PAWNREGEX_REGEX_CACHE_H_
+#define PAWNREGEX_REGEX_CACHE_H_
+
+// Plugin-wide LRU cache of compiled patterns, shared by every script
+class RegexCache {
+ public:
+  RegexPtr Get(std::string_view pattern,
+               std::regex_constants::syntax_option_type option, CharMode mode,
+               RegexEngine engine);
+
+  // Stores an already compiled pattern, e.g. one from the PatternBundle
+  void Add(std::string_view pattern,
+           std::regex_constants::syntax_option_type option, CharMode mode,
+           RegexEngine engine, RegexPtr regex);
+
+  void SetCapacity(std::size_t capacity);
+
+  std::size_t GetCapacity() const { return capacity_; }
+
+  std::size_t GetHits() const { return hits_; }
+
+  std::size_t GetMisses() const { return misses_; }
+
+  std::size_t GetEvictions() const { return evictions_; }
+
+ private:
+  using Entry = std::pair<std::string, RegexPtr>;
+
+  void SetKey(std::string_view pattern,
+              std::regex_constants::syntax_option_type option, CharMode mode,
+              RegexEngine engine);
+
+  void Evict(std::size_t capacity);
+
+  std::list<Entry> entries_;
+  std::unordered_map<std::string_view, std::list<Entry>::iterator> index_;
+  std::string key_;
+  std::size_t capacity_{};
+  std::size_t hits_{};
+  std::size_t misses_{};
+  std::size_t evictions_{};
+};
+
+#endif  // PAWNREGEX_REGEX_CACHE_H_
@@ -0,0 +1,78 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "main.h"
+
+RegexRegistry::RegexRegistry() : current_{new Snapshot} {}
+
+RegexRegistry::~RegexRegistry() { delete current_.load(); }
+
+RegexRef RegexRegistry::Find(const std::string &name) const {
+  // A snapshot is only freed while no reader is counted here, and a reader
+  // that comes in after it was replaced loads the new one
+  ++readers_;
+
+  const auto snapshot = current_.load();
+
+  const auto iter = snapshot->find(name);
+
+  auto regex = iter == snapshot->end() ? RegexRef{} : iter->second;
+
+  --readers_;
+
+  return regex;
+}
+
+void RegexRegistry::Add(const std::string &name, RegexRef regex) {
+  auto snapshot = std::make_unique<Snapshot>(*current_.load());
+
+  (*snapshot)[name] = std::move(regex);
+
+  Publish(std::move(snapshot));
+}
+
+bool RegexRegistry::Remove(const std::string &name) {
+  auto snapshot = std::make_unique<Snapshot>(*current_.load());
+  if (!snapshot->erase(name)) {
+    return false;
+  }
+
+  Publish(std::move(snapshot));
+
+  return true;
+}
+
+std::size_t RegexRegistry::Size() const { return current_.load()->size(); }
+
+void RegexRegistry::Reclaim() {
+  if (!retired_.empty() && readers_ == 0) {
+    retired_.clear();
+  }
+}
+
+void RegexRegistry::Publish(std::unique_ptr<Snapshot> snapshot) {
+  retired_.emplace_back(current_.exchange(snapshot.release()));
+
+  Reclaim();
+}
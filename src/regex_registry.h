@@ -0,0 +1,63 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PAWNREGEX_REGEX_REGISTRY_H_
+#define PAWNREGEX_REGEX_REGISTRY_H_
+
+// Regexes shared by name between scripts, see Regex_Share.
+//
+// The table is an immutable snapshot behind an atomic pointer. Find may be
+// called from any thread and never takes a lock. Changes are made on the main
+// thread by publishing a modified copy, and replaced snapshots are freed by
+// Reclaim once no reader is inside Find.
+class RegexRegistry {
+ public:
+  RegexRegistry();
+
+  ~RegexRegistry();
+
+  // Returns an empty RegexRef if nothing is shared under this name
+  RegexRef Find(const std::string &name) const;
+
+  // Replaces an earlier regex shared under the same name
+  void Add(const std::string &name, RegexRef regex);
+
+  bool Remove(const std::string &name);
+
+  std::size_t Size() const;
+
+  // Frees replaced snapshots that no reader can see anymore
+  void Reclaim();
+
+ private:
+  using Snapshot = std::unordered_map<std::string, RegexRef>;
+
+  void Publish(std::unique_ptr<Snapshot> snapshot);
+
+  std::atomic<const Snapshot *> current_;
+  std::vector<std::unique_ptr<const Snapshot>> retired_;
+  mutable std::atomic<std::size_t> readers_{};
+};
+
+#endif  // PAWNREGEX_REGEX_REGISTRY_H_
@@ -0,0 +1,61 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "main.h"
+
+std::size_t RegexSet::Add(RegexRef regex) {
+  regexes_.push_back(std::move(regex));
+
+  compiled_ = false;
+
+  return regexes_.size() - 1;
+}
+
+void RegexSet::Compile() {
+  literals_ = LiteralMatcher{};
+
+  unfiltered_.assign(regexes_.size(), false);
+
+  for (std::size_t id{}; id < regexes_.size(); ++id) {
+    const auto &info = regexes_[id]->GetInfo();
+
+    // Any of the alternatives' literals makes "a|b" a candidate
+    if (const auto &literal = info.GetRequiredLiteral(); !literal.empty()) {
+      literals_.Add(literal, id);
+    } else if (const auto &alternatives = info.GetAlternativeLiterals();
+               !alternatives.empty()) {
+      for (const auto &alternative : alternatives) {
+        literals_.Add(alternative, id);
+      }
+    } else {
+      unfiltered_[id] = true;
+    }
+  }
+
+  literals_.Build();
+
+  candidates_ = unfiltered_;
+
+  compiled_ = true;
+}
@@ -0,0 +1,76 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PAWNREGEX_REGEX_SET_H_
+#define PAWNREGEX_REGEX_SET_H_
+
+// Patterns matched in one call. Their required literals share a LiteralMatcher,
+// so only the patterns whose literal occurs reach the engine.
+class RegexSet {
+ public:
+  std::size_t Add(RegexRef regex);
+
+  void Compile();
+
+  template <typename Func>
+  void Search(const char *first, const char *last,
+              std::regex_constants::match_flag_type flags, Func on_match) {
+    if (!compiled_) {
+      Compile();
+    }
+
+    // Patterns without a required literal are always candidates
+    candidates_ = unfiltered_;
+
+    literals_.Scan(first, last,
+                   [this](std::size_t id) { candidates_[id] = true; });
+
+    for (std::size_t id{}; id < regexes_.size(); ++id) {
+      if (!candidates_[id]) {
+        continue;
+      }
+
+      SubjectMatch results;
+      if (regexes_[id]->Search(first, last, results, flags,
+                               regexes_[id].limit)) {
+        on_match(id);
+      }
+    }
+  }
+
+  std::size_t GetSize() const { return regexes_.size(); }
+
+  const RegexRef &Get(std::size_t id) const { return regexes_[id]; }
+
+ private:
+  std::vector<RegexRef> regexes_;
+  std::vector<bool> candidates_;
+  std::vector<bool> unfiltered_;
+  LiteralMatcher literals_;
+  bool compiled_{};
+};
+
+using RegexSetPtr = std::shared_ptr<RegexSet>;
+
+#endif  // PAWNREGEX_REGEX_SET_H_
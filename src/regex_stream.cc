@@ -0,0 +1,140 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "main.h"
+
+RegexStream::RegexStream(RegexRef regex, std::size_t window,
+                         std::regex_constants::match_flag_type flags)
+    : regex_{std::move(regex)}, window_{window}, flags_{flags} {}
+
+std::size_t RegexStream::Feed(std::string_view chunk) {
+  buffer_.append(chunk);
+
+  const auto count = Scan(false);
+
+  // Keep the lookback before the next search position
+  const auto drop = scan_ > kLookback ? scan_ - kLookback : 0;
+
+  buffer_.erase(0, drop);
+
+  buffer_pos_ += drop;
+  scan_ -= drop;
+
+  return count;
+}
+
+std::size_t RegexStream::Finish() {
+  const auto count = Scan(true);
+
+  buffer_.clear();
+
+  buffer_pos_ = 0;
+  scan_ = 0;
+
+  return count;
+}
+
+std::size_t RegexStream::Scan(bool last) {
+  using namespace std::regex_constants;
+
+  const auto first = buffer_.data();
+  const auto end = first + buffer_.size();
+
+  // A match can only start at or before safe without reaching past the end
+  // of the buffer, so the engine's answer up to there will not change
+  auto safe = buffer_.size();
+  if (!last) {
+    safe = buffer_.size() > window_ ? buffer_.size() - window_ : 0;
+
+    if (regex_->GetCharMode() == CharMode::kUtf8) {
+      while (safe > scan_ &&
+             (static_cast<unsigned char>(buffer_[safe]) & 0xC0) == 0x80) {
+        --safe;
+      }
+    }
+  }
+
+  // The end of the buffer is not the end of the input until it is finished
+  auto flags = flags_ | match_not_null;
+  if (!last) {
+    flags |= match_not_eol | match_not_eow;
+  }
+
+  std::size_t count{};
+  SubjectMatch results;
+
+  while (scan_ < buffer_.size()) {
+    const auto search_flags = scan_ ? flags | match_prev_avail : flags;
+
+    if (!regex_->Search(first + scan_, end, results, search_flags,
+                        regex_.limit, first)) {
+      scan_ = std::max(scan_, safe);
+
+      break;
+    }
+
+    const std::size_t start = results[0].first - first;
+    const std::size_t stop = results[0].second - first;
+
+    // A match that runs into the end of the buffer may still grow, unless it
+    // is as long as a match can be
+    if (!last &&
+        (start > safe || (stop == buffer_.size() && stop - start < window_))) {
+      scan_ = std::max(scan_, std::min(start, safe));
+
+      break;
+    }
+
+    Push(results);
+
+    ++count;
+
+    scan_ = stop;
+  }
+
+  return count;
+}
+
+void RegexStream::Push(const SubjectMatch &results) {
+  const auto first = results[0].first;
+
+  // Groups in a lookahead may end after the match
+  auto last = results[0].second;
+  for (const auto &group : results) {
+    if (group.matched) {
+      last = std::max(last, group.second);
+    }
+  }
+
+  auto match_results = std::make_shared<MatchResults>();
+
+  match_results->Assign(first, last, results);
+
+  match_results->SetGroupNames(regex_->GetGroupNames());
+
+  queued_bytes_ += match_results->GetMemorySize();
+
+  queue_.push_back({buffer_pos_ + (first - buffer_.data()),
+                    std::move(match_results)});
+}
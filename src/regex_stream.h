@@ -0,0 +1,87 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PAWNREGEX_REGEX_STREAM_H_
+#define PAWNREGEX_REGEX_STREAM_H_
+
+// Matches of a pattern in text that arrives in chunks. Only the text that may
+// still be part of a match is kept, so matches must fit into window bytes.
+class RegexStream {
+ public:
+  struct Match {
+    std::size_t pos{};  // Position of the match in the whole input
+    MatchResultsPtr results;
+  };
+
+  RegexStream(RegexRef regex, std::size_t window,
+              std::regex_constants::match_flag_type flags);
+
+  // Appends chunk and queues the final matches, returns how many
+  std::size_t Feed(std::string_view chunk);
+
+  // Ends the input and queues the rest, the stream can then take a new one
+  std::size_t Finish();
+
+  // Oldest finished match, nullptr if the queue is empty
+  const Match *Front() const {
+    return queue_.empty() ? nullptr : &queue_.front();
+  }
+
+  void Pop() {
+    queued_bytes_ -= queue_.front().results->GetMemorySize();
+
+    queue_.pop_front();
+  }
+
+  std::size_t GetBufferSize() const { return buffer_.size(); }
+
+  // Bytes held by the pattern, the buffer and the queued matches
+  std::size_t GetMemorySize() const {
+    return sizeof(*this) + regex_->GetMemorySize() + buffer_.capacity() +
+           queued_bytes_;
+  }
+
+ private:
+  // Bytes kept before the next search position: one character in any mode
+  static constexpr std::size_t kLookback = 4;
+
+  std::size_t Scan(bool last);
+
+  void Push(const SubjectMatch &results);
+
+  RegexRef regex_;
+  std::size_t window_{};
+  std::regex_constants::match_flag_type flags_{};
+
+  std::string buffer_;
+  std::size_t buffer_pos_{};  // Position of buffer_[0] in the whole input
+  std::size_t scan_{};        // Where the next search starts in buffer_
+
+  std::deque<Match> queue_;
+  std::size_t queued_bytes_{};
+};
+
+using RegexStreamPtr = std::shared_ptr<RegexStream>;
+
+#endif  // PAWNREGEX_REGEX_STREAM_H_
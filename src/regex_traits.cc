@@ -0,0 +1,326 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "main.h"
+
+namespace {
+
+constexpr std::uint16_t kVisible = kClassPrint | kClassGraph;
+constexpr std::uint16_t kSymbol = kClassPunct | kVisible;
+constexpr std::uint16_t kLower = kClassAlpha | kClassLower | kVisible;
+constexpr std::uint16_t kUpper = kClassAlpha | kClassUpper | kVisible;
+
+CharInfo GetAsciiCharInfo(std::uint32_t code) {
+  CharInfo info{0, code};
+
+  if (code < 0x20 || code == 0x7F) {
+    info.classes |= kClassCntrl;
+  } else if (code == ' ') {
+    info.classes |= kClassPrint;
+  } else {
+    info.classes |= kVisible;
+  }
+
+  if (code == ' ' || (code >= '\t' && code <= '\r')) {
+    info.classes |= kClassSpace;
+  }
+
+  if (code == ' ' || code == '\t') {
+    info.classes |= kClassBlank;
+  }
+
+  if (code >= '0' && code <= '9') {
+    info.classes |= kClassDigit | kClassXdigit;
+  } else if (code >= 'A' && code <= 'Z') {
+    info = {kUpper, code + ('a' - 'A')};
+  } else if (code >= 'a' && code <= 'z') {
+    info.classes = kLower;
+  } else if (info.classes & kClassGraph) {
+    info.classes |= kClassPunct;
+  }
+
+  if ((code >= 'A' && code <= 'F') || (code >= 'a' && code <= 'f')) {
+    info.classes |= kClassXdigit;
+  }
+
+  if (code == '_') {
+    info.classes |= kClassUnderscore;
+  }
+
+  return info;
+}
+
+// Letter of a range where upper and lower case alternate, starting with the
+// upper case one at first
+CharInfo GetPairedCharInfo(std::uint32_t code, std::uint32_t first) {
+  return (code - first) % 2 == 0 ? CharInfo{kUpper, code + 1}
+                                 : CharInfo{kLower, code};
+}
+
+CharInfo GetLatinCharInfo(std::uint32_t code) {
+  if (code < 0xA0) {
+    return {kClassCntrl, code};
+  }
+
+  if (code == 0xA0) {
+    return {kClassPrint, code};
+  }
+
+  if (code == 0xAA || code == 0xB5 || code == 0xBA) {
+    return {kLower, code};
+  }
+
+  if (code < 0xC0 || code == 0xD7 || code == 0xF7) {
+    return {kSymbol, code};
+  }
+
+  if (code < 0xDF) {
+    return {kUpper, code + 0x20};
+  }
+
+  if (code < 0x100) {
+    return {kLower, code};
+  }
+
+  // Latin Extended-A. The dotted and dotless i are left without a pair, so
+  // no ASCII letter is equal to a non-ASCII one without regard to case.
+  if (code == 0x130) {
+    return {kUpper, code};
+  }
+
+  if (code == 0x131 || code == 0x138 || code == 0x149 || code == 0x17F) {
+    return {kLower, code};
+  }
+
+  if (code == 0x178) {
+    return {kUpper, 0xFF};
+  }
+
+  if (code < 0x138) {
+    return GetPairedCharInfo(code, 0x100);
+  }
+
+  if (code < 0x149) {
+    return GetPairedCharInfo(code, 0x139);
+  }
+
+  if (code < 0x178) {
+    return GetPairedCharInfo(code, 0x14A);
+  }
+
+  return GetPairedCharInfo(code, 0x179);
+}
+
+CharInfo GetGreekCharInfo(std::uint32_t code) {
+  if (code == 0x386) {
+    return {kUpper, 0x3AC};
+  }
+
+  if (code >= 0x388 && code <= 0x38A) {
+    return {kUpper, code + 0x25};
+  }
+
+  if (code == 0x38C) {
+    return {kUpper, 0x3CC};
+  }
+
+  if (code == 0x38E || code == 0x38F) {
+    return {kUpper, code + 0x3F};
+  }
+
+  if (code >= 0x391 && code <= 0x3AB && code != 0x3A2) {
+    return {kUpper, code + 0x20};
+  }
+
+  if (code == 0x390 || (code >= 0x3AC && code <= 0x3CE)) {
+    return {kLower, code};
+  }
+
+  return {0, code};
+}
+
+CharInfo GetCyrillicCharInfo(std::uint32_t code) {
+  if (code < 0x410) {
+    return {kUpper, code + 0x50};
+  }
+
+  if (code < 0x430) {
+    return {kUpper, code + 0x20};
+  }
+
+  if (code < 0x460) {
+    return {kLower, code};
+  }
+
+  if (code < 0x482) {
+    return GetPairedCharInfo(code, 0x460);
+  }
+
+  if (code == 0x482) {
+    return {kSymbol, code};
+  }
+
+  // Combining marks
+  if (code < 0x48A) {
+    return {kVisible, code};
+  }
+
+  if (code < 0x4C0) {
+    return GetPairedCharInfo(code, 0x48A);
+  }
+
+  if (code == 0x4C0) {
+    return {kUpper, 0x4CF};
+  }
+
+  if (code < 0x4CF) {
+    return GetPairedCharInfo(code, 0x4C1);
+  }
+
+  if (code == 0x4CF) {
+    return {kLower, code};
+  }
+
+  return GetPairedCharInfo(code, 0x4D0);
+}
+
+}  // namespace
+
+CharInfo GetBuiltinCharInfo(std::uint32_t code) {
+  if (code < 0x80) {
+    return GetAsciiCharInfo(code);
+  }
+
+  if (code < 0x180) {
+    return GetLatinCharInfo(code);
+  }
+
+  if (code >= 0x370 && code < 0x400) {
+    return GetGreekCharInfo(code);
+  }
+
+  if (code >= 0x400 && code < 0x500) {
+    return GetCyrillicCharInfo(code);
+  }
+
+  return {0, code};
+}
+
+std::uint16_t LookupCharClass(std::string_view name, bool icase) {
+  const static std::unordered_map<std::string_view, std::uint16_t> class_map{
+      {"alnum", kClassAlpha | kClassDigit},
+      {"alpha", kClassAlpha},
+      {"blank", kClassBlank},
+      {"cntrl", kClassCntrl},
+      {"digit", kClassDigit},
+      {"graph", kClassGraph},
+      {"lower", kClassLower},
+      {"print", kClassPrint},
+      {"punct", kClassPunct},
+      {"space", kClassSpace},
+      {"upper", kClassUpper},
+      {"xdigit", kClassXdigit},
+      {"w", kClassAlpha | kClassDigit | kClassUnderscore},
+      {"d", kClassDigit},
+      {"s", kClassSpace},
+  };
+
+  const auto iter = class_map.find(name);
+  if (iter == class_map.end()) {
+    return 0;
+  }
+
+  // Without regard to case a lower or upper case letter is just a letter
+  if (icase && (iter->second == kClassLower || iter->second == kClassUpper)) {
+    return kClassAlpha;
+  }
+
+  return iter->second;
+}
+
+CaseCtype::CaseCtype(const CharTables<wchar_t> &tables, std::size_t refs)
+    : std::ctype<wchar_t>{refs} {
+  for (std::size_t i{}; i < kSize; ++i) {
+    lower_[i] = upper_[i] = static_cast<wchar_t>(i);
+  }
+
+  for (std::size_t i{}; i < kSize; ++i) {
+    const auto ch = static_cast<wchar_t>(i);
+    const auto lower = tables.Fold(ch);
+
+    lower_[i] = lower;
+
+    // The first upper case letter folding to a character is its upper case
+    const auto index = static_cast<std::size_t>(lower);
+    if (lower != ch && index < kSize && upper_[index] == lower &&
+        (tables.GetClasses(ch) & kClassUpper)) {
+      upper_[index] = ch;
+    }
+  }
+}
+
+wchar_t CaseCtype::do_tolower(wchar_t ch) const {
+  const auto index = static_cast<std::size_t>(ch);
+
+  return index < kSize ? lower_[index] : std::ctype<wchar_t>::do_tolower(ch);
+}
+
+const wchar_t *CaseCtype::do_tolower(wchar_t *first,
+                                     const wchar_t *last) const {
+  for (; first != last; ++first) {
+    *first = do_tolower(*first);
+  }
+
+  return last;
+}
+
+wchar_t CaseCtype::do_toupper(wchar_t ch) const {
+  const auto index = static_cast<std::size_t>(ch);
+
+  return index < kSize ? upper_[index] : std::ctype<wchar_t>::do_toupper(ch);
+}
+
+const wchar_t *CaseCtype::do_toupper(wchar_t *first,
+                                     const wchar_t *last) const {
+  for (; first != last; ++first) {
+    *first = do_toupper(*first);
+  }
+
+  return last;
+}
+
+EngineLocales::EngineLocales(const std::locale &locale) {
+  const auto &classic = std::locale::classic();
+
+  for (const bool icase : {false, true}) {
+    locales_[GetIndex(CharMode::kLocale, icase)] =
+        std::locale{locale, new CharTables<char>{locale, icase}};
+    locales_[GetIndex(CharMode::kBytes, icase)] =
+        std::locale{classic, new CharTables<char>{icase}};
+    const auto tables = new CharTables<wchar_t>{icase};
+
+    locales_[GetIndex(CharMode::kUtf8, icase)] =
+        std::locale{std::locale{classic, tables}, new CaseCtype{*tables}};
+  }
+}
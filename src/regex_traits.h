@@ -0,0 +1,324 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PAWNREGEX_REGEX_TRAITS_H_
+#define PAWNREGEX_REGEX_TRAITS_H_
+
+// How a pattern and its subjects are read, see REGEX_LOCALE, REGEX_BYTES and
+// REGEX_UTF8
+enum class CharMode {
+  kLocale,  // Bytes, classified by the configured locale
+  kBytes,   // Bytes, only ASCII has classes and case
+  kUtf8,    // Code points of UTF-8 text
+};
+
+enum CharClass : std::uint16_t {
+  kClassAlpha = 1 << 0,
+  kClassDigit = 1 << 1,
+  kClassXdigit = 1 << 2,
+  kClassUpper = 1 << 3,
+  kClassLower = 1 << 4,
+  kClassSpace = 1 << 5,
+  kClassBlank = 1 << 6,
+  kClassCntrl = 1 << 7,
+  kClassPunct = 1 << 8,
+  kClassPrint = 1 << 9,
+  kClassGraph = 1 << 10,
+  kClassUnderscore = 1 << 11,
+};
+
+struct CharInfo {
+  std::uint16_t classes{};
+  std::uint32_t fold{};
+};
+
+// Classes and lower case of a code point in the built-in tables, which cover
+// ASCII, Latin-1, Latin Extended-A, Greek and Cyrillic
+CharInfo GetBuiltinCharInfo(std::uint32_t code);
+
+// Returns 0 if the name is unknown
+std::uint16_t LookupCharClass(std::string_view name, bool icase);
+
+// Classes and lower case of the first kSize characters, a facet of the engine
+// locale of a CharMode
+template <typename CharT>
+class CharTables : public std::locale::facet {
+ public:
+  static constexpr std::size_t kSize = sizeof(CharT) == 1 ? 0x100 : 0x500;
+
+  static inline std::locale::id id;
+
+  // Built-in tables. For char only ASCII is classified, the other bytes are
+  // left alone.
+  explicit CharTables(bool icase, std::size_t refs = 0)
+      : std::locale::facet{refs}, icase_{icase} {
+    for (std::size_t i{}; i < kSize; ++i) {
+      const auto info = sizeof(CharT) == 1 && i >= 0x80
+                            ? CharInfo{0, static_cast<std::uint32_t>(i)}
+                            : GetBuiltinCharInfo(i);
+
+      classes_[i] = info.classes;
+      fold_[i] = static_cast<CharT>(info.fold);
+    }
+  }
+
+  // Tables of the ctype facet of locale. Collation is taken from the locale
+  // as well.
+  CharTables(const std::locale &locale, bool icase, std::size_t refs = 0)
+      : std::locale::facet{refs}, icase_{icase}, collates_{true} {
+    const auto &ctype = std::use_facet<std::ctype<CharT>>(locale);
+
+    const std::pair<std::ctype_base::mask, std::uint16_t> masks[] = {
+        {std::ctype_base::alpha, kClassAlpha},
+        {std::ctype_base::digit, kClassDigit},
+        {std::ctype_base::xdigit, kClassXdigit},
+        {std::ctype_base::upper, kClassUpper},
+        {std::ctype_base::lower, kClassLower},
+        {std::ctype_base::space, kClassSpace},
+        {std::ctype_base::blank, kClassBlank},
+        {std::ctype_base::cntrl, kClassCntrl},
+        {std::ctype_base::punct, kClassPunct},
+        {std::ctype_base::print, kClassPrint},
+        {std::ctype_base::graph, kClassGraph},
+    };
+
+    for (std::size_t i{}; i < kSize; ++i) {
+      const auto ch = static_cast<CharT>(i);
+
+      std::uint16_t classes{};
+      for (const auto &[mask, bit] : masks) {
+        if (ctype.is(mask, ch)) {
+          classes |= bit;
+        }
+      }
+
+      if (ch == ctype.widen('_')) {
+        classes |= kClassUnderscore;
+      }
+
+      classes_[i] = classes;
+      fold_[i] = ctype.tolower(ch);
+    }
+  }
+
+  std::uint16_t GetClasses(CharT ch) const {
+    const auto index = ToIndex(ch);
+
+    return index < kSize ? classes_[index] : 0;
+  }
+
+  CharT Fold(CharT ch) const {
+    const auto index = ToIndex(ch);
+
+    return index < kSize ? fold_[index] : ch;
+  }
+
+  // Whether RegexTraits::transform folds case. That is how back-references
+  // of case-insensitive patterns are compared.
+  bool IsCaseInsensitive() const { return icase_; }
+
+  // Whether RegexTraits::transform uses the collate facet of the locale
+  bool Collates() const { return collates_; }
+
+ private:
+  static std::size_t ToIndex(CharT ch) {
+    return static_cast<std::make_unsigned_t<CharT>>(ch);
+  }
+
+  std::array<std::uint16_t, kSize> classes_{};
+  std::array<CharT, kSize> fold_{};
+  bool icase_{};
+  bool collates_{};
+};
+
+// Case mapping of the UTF-8 engine locale. libstdc++ folds the ends of a
+// bracket range with the ctype facet of the locale instead of the traits.
+class CaseCtype : public std::ctype<wchar_t> {
+ public:
+  explicit CaseCtype(const CharTables<wchar_t> &tables, std::size_t refs = 0);
+
+ protected:
+  wchar_t do_tolower(wchar_t ch) const override;
+
+  const wchar_t *do_tolower(wchar_t *first,
+                            const wchar_t *last) const override;
+
+  wchar_t do_toupper(wchar_t ch) const override;
+
+  const wchar_t *do_toupper(wchar_t *first,
+                            const wchar_t *last) const override;
+
+ private:
+  static constexpr std::size_t kSize = CharTables<wchar_t>::kSize;
+
+  std::array<wchar_t, kSize> lower_{};
+  std::array<wchar_t, kSize> upper_{};
+};
+
+// Engine traits reading the CharTables instead of the locale's ctype facet
+template <typename CharT>
+class RegexTraits {
+ public:
+  using char_type = CharT;
+  using string_type = std::basic_string<CharT>;
+  using locale_type = std::locale;
+  using char_class_type = std::uint16_t;
+
+  RegexTraits() { imbue(locale_type{}); }
+
+  static std::size_t length(const char_type *str) {
+    return std::char_traits<char_type>::length(str);
+  }
+
+  char_type translate(char_type ch) const { return ch; }
+
+  char_type translate_nocase(char_type ch) const { return tables_->Fold(ch); }
+
+  template <typename ForwardIt>
+  string_type transform(ForwardIt first, ForwardIt last) const {
+    string_type str(first, last);
+
+    if (tables_->IsCaseInsensitive()) {
+      for (auto &ch : str) {
+        ch = tables_->Fold(ch);
+      }
+    }
+
+    if (!tables_->Collates()) {
+      return str;
+    }
+
+    const auto &collate = std::use_facet<std::collate<char_type>>(locale_);
+
+    return collate.transform(str.data(), str.data() + str.size());
+  }
+
+  template <typename ForwardIt>
+  string_type transform_primary(ForwardIt first, ForwardIt last) const {
+    string_type str(first, last);
+
+    for (auto &ch : str) {
+      ch = tables_->Fold(ch);
+    }
+
+    return transform(str.begin(), str.end());
+  }
+
+  // The locale knows the POSIX names, such as [[.hyphen.]]. The other modes
+  // only know single characters.
+  template <typename ForwardIt>
+  string_type lookup_collatename(ForwardIt first, ForwardIt last) const {
+    if (tables_->Collates()) {
+      std::regex_traits<char_type> traits;
+      traits.imbue(locale_);
+
+      return traits.lookup_collatename(first, last);
+    }
+
+    string_type name(first, last);
+
+    return name.size() == 1 ? name : string_type{};
+  }
+
+  template <typename ForwardIt>
+  char_class_type lookup_classname(ForwardIt first, ForwardIt last,
+                                   bool icase = false) const {
+    // The engine asks for "w" at every word boundary check
+    if (first != last && std::next(first) == last &&
+        *first == char_type('w')) {
+      return kClassAlpha | kClassDigit | kClassUnderscore;
+    }
+
+    std::string name;
+
+    for (; first != last; ++first) {
+      const auto ch = *first;
+      if (ch < 0 || ch > 0x7F) {
+        return 0;
+      }
+
+      name.push_back(static_cast<char>(ch));
+    }
+
+    return LookupCharClass(name, icase);
+  }
+
+  bool isctype(char_type ch, char_class_type mask) const {
+    return (tables_->GetClasses(ch) & mask) != 0;
+  }
+
+  int value(char_type ch, int radix) const {
+    int digit = -1;
+
+    if (ch >= char_type('0') && ch <= char_type('9')) {
+      digit = ch - char_type('0');
+    } else if (ch >= char_type('a') && ch <= char_type('f')) {
+      digit = ch - char_type('a') + 10;
+    } else if (ch >= char_type('A') && ch <= char_type('F')) {
+      digit = ch - char_type('A') + 10;
+    }
+
+    return digit < radix ? digit : -1;
+  }
+
+  // Patterns get their tables from the EngineLocales. Any other locale falls
+  // back to the built-in ones.
+  locale_type imbue(locale_type locale) {
+    static const CharTables<CharT> builtin{false, 1};
+
+    tables_ = std::has_facet<CharTables<CharT>>(locale)
+                  ? &std::use_facet<CharTables<CharT>>(locale)
+                  : &builtin;
+
+    std::swap(locale_, locale);
+
+    return locale;
+  }
+
+  locale_type getloc() const { return locale_; }
+
+ private:
+  locale_type locale_;
+  const CharTables<CharT> *tables_{};
+};
+
+// Engine locales for every CharMode and case sensitivity, built when the
+// config is read
+class EngineLocales {
+ public:
+  explicit EngineLocales(const std::locale &locale = std::locale::classic());
+
+  const std::locale &Get(CharMode mode, bool icase) const {
+    return locales_[GetIndex(mode, icase)];
+  }
+
+ private:
+  static std::size_t GetIndex(CharMode mode, bool icase) {
+    return static_cast<std::size_t>(mode) * 2 + (icase ? 1 : 0);
+  }
+
+  std::array<std::locale, 6> locales_;
+};
+
+#endif  // PAWNREGEX_REGEX_TRAITS_H_
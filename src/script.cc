@@ -24,11 +24,37 @@
 
 #include "main.h"
 
+Script::~Script() {
+  *alive_ = false;
+
+  auto &plugin = Plugin::Instance();
+
+  plugin.RemoveScopedScript(this);
+
+  plugin.GetMemoryUsage().Remove(memory_usage_);
+
+  if (memory_usage_.GetPeakBytes()) {
+    plugin.Log("script unloaded, memory usage peak: %s",
+               memory_usage_.ToString(true).c_str());
+  }
+}
+
 // native Regex:Regex_New(const pattern[], E_REGEX_FLAG:flags = REGEX_DEFAULT,
 // E_REGEX_GRAMMAR:grammar = REGEX_ECMASCRIPT);
 cell Script::Regex_New(std::string pattern, E_REGEX_FLAG flags,
                        E_REGEX_GRAMMAR grammar) {
-  return NewRegex(pattern, GetRegexFlag(flags, grammar));
+  return NewRegex(pattern, GetRegexFlag(flags, grammar), GetCharMode(flags),
+                  GetEngine(flags));
+}
+
+// native Regex:Regex_Get(const name[]);
+cell Script::Regex_Get(std::string name) {
+  const auto regex = Plugin::Instance().GetPatternBundle().Find(name);
+  if (!regex) {
+    throw std::runtime_error{"Pattern " + name + " not found in the bundle"};
+  }
+
+  return AddRegex(regex);
 }
 
 // native Regex_Delete(&Regex:r);
@@ -40,50 +66,755 @@ cell Script::Regex_Delete(cell *regex) {
   return 1;
 }
 
+// native Regex_Share(Regex:r, const name[]);
+cell Script::Regex_Share(RegexRef regex, std::string name) {
+  Plugin::Instance().GetRegexRegistry().Add(name, std::move(regex));
+
+  return 1;
+}
+
+// native Regex:Regex_Import(const name[]);
+cell Script::Regex_Import(std::string name) {
+  auto regex = Plugin::Instance().GetRegexRegistry().Find(name);
+  if (!regex) {
+    throw std::runtime_error{"Regex " + name + " is not shared"};
+  }
+
+  return AddRegex(std::move(regex));
+}
+
+// native Regex_Unshare(const name[]);
+cell Script::Regex_Unshare(std::string name) {
+  return Plugin::Instance().GetRegexRegistry().Remove(name) ? 1 : 0;
+}
+
 // native Regex_Check(const str[], Regex:r, E_MATCH_FLAG:flags = MATCH_DEFAULT);
-cell Script::Regex_Check(std::string str, RegexPtr regex, E_MATCH_FLAG flags) {
-  return std::regex_match(str, *regex, GetMatchFlag(flags)) ? 1 : 0;
+cell Script::Regex_Check(AmxString str, RegexRef regex, E_MATCH_FLAG flags) {
+  last_error_ = REGEX_ERROR_NONE;
+
+  try {
+    return regex->Match(str.begin(), str.end(), GetMatchFlag(flags),
+                        regex.limit)
+               ? 1
+               : 0;
+  } catch (const MatchTimeout &) {
+    return SetLastError(REGEX_ERROR_TIMEOUT);
+  }
 }
 
 // native Regex_Match(const str[], Regex:r, &RegexMatch:m, E_MATCH_FLAG:flags =
 // MATCH_DEFAULT);
-cell Script::Regex_Match(std::string str, RegexPtr regex, cell *match_results,
+cell Script::Regex_Match(AmxString str, RegexRef regex, cell *match_results,
                          E_MATCH_FLAG flags) {
-  std::smatch results;
-  if (std::regex_match(str, results, *regex, GetMatchFlag(flags))) {
-    *match_results = NewMatchResults(results);
+  last_error_ = REGEX_ERROR_NONE;
 
-    return 1;
+  SubjectMatch results;
+
+  try {
+    if (!regex->Match(str.begin(), str.end(), results, GetMatchFlag(flags),
+                      regex.limit)) {
+      return 0;
+    }
+  } catch (const MatchTimeout &) {
+    return SetLastError(REGEX_ERROR_TIMEOUT);
   }
 
-  return 0;
+  try {
+    *match_results = NewMatchResults(str.begin(), str.end(), results, *regex);
+  } catch (const MemoryLimitError &) {
+    return SetLastError(REGEX_ERROR_LIMIT);
+  }
+
+  return 1;
 }
 
 // native Regex_Search(const str[], Regex:r, &RegexMatch:m, &pos, startpos = 0,
 // E_MATCH_FLAG:flags = MATCH_DEFAULT);
-cell Script::Regex_Search(std::string str, RegexPtr regex, cell *match_results,
+cell Script::Regex_Search(AmxString str, RegexRef regex, cell *match_results,
                           cell *pos, cell startpos, E_MATCH_FLAG flags) {
-  str = str.substr(startpos);
+  last_error_ = REGEX_ERROR_NONE;
 
-  std::smatch results;
-  if (std::regex_search(str, results, *regex, GetMatchFlag(flags))) {
-    *match_results = NewMatchResults(results);
+  if (startpos < 0 || static_cast<std::size_t>(startpos) > str.size()) {
+    return 0;
+  }
 
-    *pos = results.position();
+  // Characters before startpos still count for "^", "\b" and lookbehind,
+  // unless MATCH_RELATIVE_POS treats startpos as the beginning
+  const bool relative = flags & MATCH_RELATIVE_POS;
+  const auto first = str.begin() + startpos;
 
-    return 1;
+  auto match_flags = GetMatchFlag(flags);
+  if (startpos > 0 && !relative) {
+    match_flags |= std::regex_constants::match_prev_avail;
   }
 
-  return 0;
+  SubjectMatch results;
+
+  try {
+    if (!regex->Search(first, str.end(), results, match_flags, regex.limit,
+                       str.begin())) {
+      return 0;
+    }
+  } catch (const MatchTimeout &) {
+    return SetLastError(REGEX_ERROR_TIMEOUT);
+  }
+
+  const auto subject = relative ? first : str.begin();
+
+  try {
+    *match_results = NewMatchResults(subject, str.end(), results, *regex);
+  } catch (const MemoryLimitError &) {
+    return SetLastError(REGEX_ERROR_LIMIT);
+  }
+
+  *pos = results[0].first - subject;
+
+  return 1;
 }
 
 // native Regex_Replace(const str[], Regex:r, const fmt[], dest[],
 // E_MATCH_FLAG:flags = MATCH_DEFAULT, size = sizeof dest);
-cell Script::Regex_Replace(std::string str, RegexPtr regex, std::string fmt,
+cell Script::Regex_Replace(AmxString str, RegexRef regex, AmxString fmt,
                            cell *dest, E_MATCH_FLAG flags, cell size) {
-  const auto result = std::regex_replace(str, *regex, fmt, GetMatchFlag(flags));
+  cell needed{}, replacements{};
+
+  return Regex_ReplaceEx(str, regex, fmt, dest, &needed, &replacements, flags,
+                         size);
+}
+
+// native Regex_ReplaceEx(const str[], Regex:r, const fmt[], dest[], &needed,
+// &replacements, E_MATCH_FLAG:flags = MATCH_DEFAULT, size = sizeof dest);
+cell Script::Regex_ReplaceEx(AmxString str, RegexRef regex, AmxString fmt,
+                             cell *dest, cell *needed, cell *replacements,
+                             E_MATCH_FLAG flags, cell size) {
+  last_error_ = REGEX_ERROR_NONE;
+
+  // The result goes straight into dest, str and fmt are already copies
+  AmxStringWriter writer{dest, size};
+
+  try {
+    *replacements =
+        regex->Replace(writer.begin(), str.begin(), str.end(), fmt.view(),
+                       GetMatchFlag(flags), regex.limit);
+  } catch (const MatchTimeout &) {
+    writer.Clear();
+    writer.Finish();
+
+    *needed = 0;
+    *replacements = 0;
+
+    return SetLastError(REGEX_ERROR_TIMEOUT);
+  }
+
+  writer.Finish();
+
+  *needed = writer.GetLength();
+
+  if (writer.IsTruncated()) {
+    return SetLastError(REGEX_ERROR_TRUNCATED);
+  }
+
+  return 1;
+}
+
+// native Regex_SearchAsync(const str[], Regex:r, const callback[], data = 0,
+// startpos = 0, E_MATCH_FLAG:flags = MATCH_DEFAULT);
+cell Script::Regex_SearchAsync(AmxString str, RegexRef regex,
+                               std::string callback, cell data, cell startpos,
+                               E_MATCH_FLAG flags) {
+  if (startpos < 0 || static_cast<std::size_t>(startpos) > str.size()) {
+    return 0;
+  }
+
+  // The same positions as Regex_Search
+  const bool relative = flags & MATCH_RELATIVE_POS;
+
+  auto match_flags = GetMatchFlag(flags);
+  if (startpos > 0 && !relative) {
+    match_flags |= std::regex_constants::match_prev_avail;
+  }
+
+  Plugin::Instance().GetWorkerPool().Push(
+      [this, alive = alive_, regex, subject = std::string{str.view()},
+       callback = std::move(callback), data, startpos, relative,
+       match_flags] {
+        try {
+          const auto first = subject.data();
+          const auto last = first + subject.size();
+
+          MatchResultsPtr match_results;
+
+          SubjectMatch results;
+          if (regex->Search(first + startpos, last, results, match_flags,
+                            regex.limit, first)) {
+            match_results = std::make_shared<MatchResults>();
+
+            match_results->Assign(relative ? first + startpos : first, last,
+                                  results);
+
+            match_results->SetGroupNames(regex->GetGroupNames());
+          }
+
+          Plugin::Instance().PushCompletion(
+              [this, alive, callback, data, match_results] {
+                if (*alive) {
+                  CompleteSearchAsync(callback, data, match_results);
+                }
+              });
+        } catch (const std::exception &e) {
+          Plugin::Instance().PushCompletion(
+              [this, alive, callback, data, error = std::string{e.what()}] {
+                if (!*alive) {
+                  return;
+                }
+
+                CompleteSearchAsync(callback, data, nullptr);
+
+                throw std::runtime_error{error};
+              });
+        }
+      });
+
+  return 1;
+}
+
+// native Regex_ReplaceAsync(const str[], Regex:r, const fmt[],
+// const callback[], data = 0, E_MATCH_FLAG:flags = MATCH_DEFAULT);
+cell Script::Regex_ReplaceAsync(AmxString str, RegexRef regex, AmxString fmt,
+                                std::string callback, cell data,
+                                E_MATCH_FLAG flags) {
+  Plugin::Instance().GetWorkerPool().Push(
+      [this, alive = alive_, regex, subject = std::string{str.view()},
+       fmt = std::string{fmt.view()}, callback = std::move(callback), data,
+       match_flags = GetMatchFlag(flags)] {
+        try {
+          std::string result;
+
+          regex->Replace(std::back_inserter(result), subject.data(),
+                         subject.data() + subject.size(), fmt, match_flags,
+                         regex.limit);
+
+          Plugin::Instance().PushCompletion(
+              [this, alive, callback, data, result = std::move(result)] {
+                if (*alive) {
+                  CompleteReplaceAsync(callback, data, result);
+                }
+              });
+        } catch (const std::exception &e) {
+          Plugin::Instance().PushCompletion(
+              [this, alive, callback, data, error = std::string{e.what()}] {
+                if (!*alive) {
+                  return;
+                }
+
+                CompleteReplaceAsync(callback, data, {});
+
+                throw std::runtime_error{error};
+              });
+        }
+      });
+
+  return 1;
+}
+
+// native Regex_SearchAll(const str[], Regex:r, &RegexMatchList:list,
+// E_MATCH_FLAG:flags = MATCH_DEFAULT);
+cell Script::Regex_SearchAll(AmxString str, RegexRef regex, cell *match_list,
+                             E_MATCH_FLAG flags) {
+  last_error_ = REGEX_ERROR_NONE;
+
+  const auto list = std::make_shared<MatchList>();
+
+  list->SetSubject(str.begin(), str.end());
+
+  try {
+    regex->SearchAll(str.begin(), str.end(), GetMatchFlag(flags), regex.limit,
+                     [&list, &str](const SubjectMatch &results) {
+                       list->Append(str.begin(), results);
+                     });
+  } catch (const MatchTimeout &) {
+    *match_list = 0;
+
+    return SetLastError(REGEX_ERROR_TIMEOUT);
+  }
+
+  const auto count = list->GetMatchCount();
+  if (!count) {
+    *match_list = 0;
+
+    return 0;
+  }
+
+  try {
+    AddMemory(MemoryKind::kMatch, list->GetMemorySize());
+  } catch (const MemoryLimitError &) {
+    *match_list = 0;
+
+    return SetLastError(REGEX_ERROR_LIMIT);
+  }
+
+  *match_list = match_lists_.Add(list);
+
+  return count;
+}
+
+// native Regex_SearchAllPos(const str[], Regex:r, spans[], &count,
+// E_MATCH_FLAG:flags = MATCH_DEFAULT, size = sizeof spans);
+cell Script::Regex_SearchAllPos(AmxString str, RegexRef regex, cell *spans,
+                                cell *count, E_MATCH_FLAG flags, cell size) {
+  last_error_ = REGEX_ERROR_NONE;
+
+  *count = 0;
+
+  try {
+    regex->SearchAll(
+        str.begin(), str.end(), GetMatchFlag(flags), regex.limit,
+        [spans, count, size, &str](const SubjectMatch &results) {
+          if ((*count + 1) * 2 > size) {
+            return;
+          }
+
+          const auto &match = results[0];
+
+          spans[*count * 2] = match.first - str.begin();
+          spans[*count * 2 + 1] = match.second - match.first;
+
+          ++*count;
+        });
+  } catch (const MatchTimeout &) {
+    *count = 0;
+
+    return SetLastError(REGEX_ERROR_TIMEOUT);
+  }
+
+  return *count;
+}
+
+// native Regex_CheckMany(const strings[][], count, Regex:r, results[],
+// E_MATCH_FLAG:flags = MATCH_DEFAULT, size = sizeof results, rows = sizeof
+// strings);
+cell Script::Regex_CheckMany(cell *strings, cell count, RegexRef regex,
+                             cell *results, E_MATCH_FLAG flags, cell size,
+                             cell rows) {
+  count = std::max<cell>(std::min({count, size, rows}), 0);
+
+  // Throws before any row is touched if count is beyond the array
+  if (count) {
+    GetAmxArrayRow(strings, count - 1);
+  }
+
+  last_error_ = REGEX_ERROR_NONE;
+
+  const auto match_flags = GetMatchFlag(flags);
+
+  std::atomic<cell> matched{};
+  std::atomic<bool> timed_out{};
+
+  RunBatch(count, [&](std::size_t first, std::size_t last) {
+    cell chunk_matched{};
+
+    for (auto row = first; row < last; ++row) {
+      const AmxString str{GetAmxArrayRow(strings, row)};
+
+      try {
+        results[row] =
+            regex->Match(str.begin(), str.end(), match_flags, regex.limit);
+      } catch (const MatchTimeout &) {
+        results[row] = 0;
+
+        timed_out = true;
+      }
+
+      chunk_matched += results[row];
+    }
+
+    matched += chunk_matched;
+  });
+
+  if (timed_out) {
+    last_error_ = REGEX_ERROR_TIMEOUT;
+  }
+
+  return matched;
+}
+
+// native Regex_ReplaceMany(const strings[][], count, Regex:r, const fmt[],
+// dest[][], E_MATCH_FLAG:flags = MATCH_DEFAULT, size = sizeof dest[], rows =
+// sizeof strings, dest_rows = sizeof dest);
+cell Script::Regex_ReplaceMany(cell *strings, cell count, RegexRef regex,
+                               AmxString fmt, cell *dest, E_MATCH_FLAG flags,
+                               cell size, cell rows, cell dest_rows) {
+  count = std::max<cell>(std::min({count, rows, dest_rows}), 0);
+
+  if (count) {
+    GetAmxArrayRow(strings, count - 1);
+    GetAmxArrayRow(dest, count - 1);
+  }
+
+  last_error_ = REGEX_ERROR_NONE;
+
+  const auto match_flags = GetMatchFlag(flags);
+
+  // Row strings are read into the same thread-local buffers as fmt
+  const std::string format{fmt.view()};
+
+  std::atomic<cell> replaced{};
+  std::atomic<bool> timed_out{};
+
+  RunBatch(count, [&](std::size_t first, std::size_t last) {
+    cell chunk_replaced{};
+
+    for (auto row = first; row < last; ++row) {
+      const AmxString str{GetAmxArrayRow(strings, row)};
+
+      AmxStringWriter writer{GetAmxArrayRow(dest, row), size};
+
+      try {
+        regex->Replace(writer.begin(), str.begin(), str.end(), format,
+                       match_flags, regex.limit);
+
+        ++chunk_replaced;
+      } catch (const MatchTimeout &) {
+        writer.Clear();
+
+        timed_out = true;
+      }
+
+      writer.Finish();
+    }
+
+    replaced += chunk_replaced;
+  });
+
+  if (timed_out) {
+    last_error_ = REGEX_ERROR_TIMEOUT;
+  }
+
+  return replaced;
+}
+
+// native Regex_CheckP(const str[], const pattern[], E_MATCH_FLAG:flags =
+// MATCH_DEFAULT, E_REGEX_FLAG:regex_flags = REGEX_DEFAULT,
+// E_REGEX_GRAMMAR:grammar = REGEX_ECMASCRIPT);
+cell Script::Regex_CheckP(AmxString str, AmxString pattern, E_MATCH_FLAG flags,
+                          E_REGEX_FLAG regex_flags, E_REGEX_GRAMMAR grammar) {
+  const auto regex = Plugin::Instance().GetRegexCache().Get(
+      pattern.view(), GetRegexFlag(regex_flags, grammar),
+      GetCharMode(regex_flags), GetEngine(regex_flags));
+
+  return Regex_Check(
+      str, {regex, Plugin::Instance().GetDefaultMatchLimit()}, flags);
+}
+
+// native Regex_ReplaceP(const str[], const pattern[], const fmt[], dest[],
+// E_MATCH_FLAG:flags = MATCH_DEFAULT, E_REGEX_FLAG:regex_flags =
+// REGEX_DEFAULT, E_REGEX_GRAMMAR:grammar = REGEX_ECMASCRIPT, size = sizeof
+// dest);
+cell Script::Regex_ReplaceP(AmxString str, AmxString pattern, AmxString fmt,
+                            cell *dest, E_MATCH_FLAG flags,
+                            E_REGEX_FLAG regex_flags, E_REGEX_GRAMMAR grammar,
+                            cell size) {
+  const auto regex = Plugin::Instance().GetRegexCache().Get(
+      pattern.view(), GetRegexFlag(regex_flags, grammar),
+      GetCharMode(regex_flags), GetEngine(regex_flags));
+
+  return Regex_Replace(str, {regex, Plugin::Instance().GetDefaultMatchLimit()},
+                       fmt, dest, flags, size);
+}
+
+// native Regex_GetCacheStats(&hits, &misses, &evictions);
+cell Script::Regex_GetCacheStats(cell *hits, cell *misses, cell *evictions) {
+  const auto &cache = Plugin::Instance().GetRegexCache();
+
+  *hits = cache.GetHits();
+  *misses = cache.GetMisses();
+  *evictions = cache.GetEvictions();
+
+  return 1;
+}
+
+// native Regex_GetGroupIndex(Regex:r, const name[]);
+cell Script::Regex_GetGroupIndex(RegexRef regex, AmxString name) {
+  return regex->GetGroupIndex(name.view());
+}
+
+// native Regex_SetLimit(Regex:r, microseconds, steps);
+cell Script::Regex_SetLimit(cell regex, cell microseconds, cell steps) {
+  GetRegex(regex);
+
+  // The Regex may be shared with other handles and scripts by RegexCache and
+  // RegexRegistry, so the limit stays with this handle
+  auto &limit = regexes_.Find(regex)->limit;
+
+  limit.time = std::chrono::microseconds{std::max<cell>(microseconds, 0)};
+  limit.steps = std::max<cell>(steps, 0);
+
+  return 1;
+}
+
+// native Regex_GetTimeoutCount(Regex:r);
+cell Script::Regex_GetTimeoutCount(RegexRef regex) {
+  return regex->GetTimeoutCount();
+}
+
+// native E_REGEX_ERROR:Regex_GetLastError();
+cell Script::Regex_GetLastError() { return last_error_; }
+
+// native Regex_GetStats(Regex:r, &calls, &matches, &misses, &total_us,
+// &max_us, &compile_us);
+cell Script::Regex_GetStats(RegexRef regex, cell *calls, cell *matches,
+                            cell *misses, cell *total_us, cell *max_us,
+                            cell *compile_us) {
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+
+  const auto &stats = regex->GetStats();
+
+  *calls = static_cast<cell>(stats.GetCalls());
+  *matches = static_cast<cell>(stats.GetMatches());
+  *misses = static_cast<cell>(stats.GetMisses());
+  *total_us = static_cast<cell>(
+      duration_cast<microseconds>(stats.GetTotalTime()).count());
+  *max_us = static_cast<cell>(
+      duration_cast<microseconds>(stats.GetMaxTime()).count());
+  *compile_us = static_cast<cell>(
+      duration_cast<microseconds>(regex->GetCompileTime()).count());
+
+  return Profiler::IsEnabled() ? 1 : 0;
+}
+
+// native Regex_GetLengthHistogram(Regex:r, buckets[], size = sizeof buckets);
+cell Script::Regex_GetLengthHistogram(RegexRef regex, cell *buckets,
+                                      cell size) {
+  const auto &stats = regex->GetStats();
+
+  const auto count = std::min<std::size_t>(std::max<cell>(size, 0),
+                                           CallStats::kLengthBuckets);
+
+  for (std::size_t bucket{}; bucket < count; ++bucket) {
+    buckets[bucket] = static_cast<cell>(stats.GetLengthCount(bucket));
+  }
+
+  return count;
+}
+
+// native Regex_DumpStats();
+cell Script::Regex_DumpStats() {
+  Plugin::Instance().DumpProfile();
+
+  return 1;
+}
+
+// native Regex_GetMemoryUsage(&regexes, &regex_bytes, &matches,
+// &match_bytes, bool:peak = false, bool:global = false);
+cell Script::Regex_GetMemoryUsage(cell *regexes, cell *regex_bytes,
+                                  cell *matches, cell *match_bytes, cell peak,
+                                  cell global) {
+  const auto &usage =
+      global ? Plugin::Instance().GetMemoryUsage() : memory_usage_;
+
+  if (peak) {
+    *regexes = usage.GetPeakCount(MemoryKind::kRegex);
+    *regex_bytes = usage.GetPeakBytes(MemoryKind::kRegex);
+    *matches = usage.GetPeakCount(MemoryKind::kMatch);
+    *match_bytes = usage.GetPeakBytes(MemoryKind::kMatch);
+
+    return usage.GetPeakBytes();
+  }
+
+  *regexes = usage.GetCount(MemoryKind::kRegex);
+  *regex_bytes = usage.GetBytes(MemoryKind::kRegex);
+  *matches = usage.GetCount(MemoryKind::kMatch);
+  *match_bytes = usage.GetBytes(MemoryKind::kMatch);
+
+  return usage.GetBytes();
+}
+
+// native RegexSet:RegexSet_New();
+cell Script::RegexSet_New() {
+  AddMemory(MemoryKind::kRegex, sizeof(RegexSet));
+
+  return regex_sets_.Add(std::make_shared<RegexSet>());
+}
+
+// native RegexSet_Delete(&RegexSet:set);
+cell Script::RegexSet_Delete(cell *regex_set) {
+  const auto &set = GetRegexSet(*regex_set);
+
+  for (std::size_t id{}; id < set->GetSize(); ++id) {
+    RemoveMemory(MemoryKind::kRegex, set->Get(id)->GetMemorySize());
+  }
+
+  RemoveMemory(MemoryKind::kRegex, sizeof(RegexSet));
+
+  regex_sets_.Remove(*regex_set);
+
+  *regex_set = 0;
+
+  return 1;
+}
+
+// native RegexSet_Add(RegexSet:set, const pattern[], E_REGEX_FLAG:flags =
+// REGEX_DEFAULT, E_REGEX_GRAMMAR:grammar = REGEX_ECMASCRIPT);
+cell Script::RegexSet_Add(cell regex_set, std::string pattern,
+                          E_REGEX_FLAG flags, E_REGEX_GRAMMAR grammar) {
+  auto &plugin = Plugin::Instance();
+
+  // 0 is the first id, so failures return -1 instead of the usual 0
+  try {
+    const auto &set = GetRegexSet(regex_set);
+
+    // Every member counts as a regex handle
+    CheckMemory(MemoryKind::kRegex, 0);
+
+    auto regex = plugin.GetRegexCache().Get(
+        pattern, GetRegexFlag(flags, grammar), GetCharMode(flags),
+        GetEngine(flags));
+
+    AddMemory(MemoryKind::kRegex, regex->GetMemorySize());
 
-  SetString(dest, result, size);
+    return set->Add({std::move(regex), plugin.GetDefaultMatchLimit()});
+  } catch (const std::exception &e) {
+    plugin.Log("RegexSet_Add: %s", e.what());
+
+    return -1;
+  }
+}
+
+// native RegexSet_Compile(RegexSet:set);
+cell Script::RegexSet_Compile(RegexSetPtr regex_set) {
+  regex_set->Compile();
+
+  return 1;
+}
+
+// native RegexSet_Match(const str[], RegexSet:set, matched_ids[], &count,
+// E_MATCH_FLAG:flags = MATCH_DEFAULT, size = sizeof matched_ids);
+cell Script::RegexSet_Match(AmxString str, RegexSetPtr regex_set,
+                            cell *matched_ids, cell *count, E_MATCH_FLAG flags,
+                            cell size) {
+  last_error_ = REGEX_ERROR_NONE;
+
+  *count = 0;
+
+  try {
+    regex_set->Search(str.begin(), str.end(), GetMatchFlag(flags),
+                      [matched_ids, count, size](std::size_t id) {
+                        if (*count < size) {
+                          matched_ids[(*count)++] = id;
+                        }
+                      });
+  } catch (const MatchTimeout &) {
+    *count = 0;
+
+    return SetLastError(REGEX_ERROR_TIMEOUT);
+  }
+
+  return *count ? 1 : 0;
+}
+
+// native RegexStream:RegexStream_New(Regex:r, window = 256,
+// E_MATCH_FLAG:flags = MATCH_DEFAULT);
+cell Script::RegexStream_New(RegexRef regex, cell window, E_MATCH_FLAG flags) {
+  if (window <= 0) {
+    throw std::invalid_argument{"Invalid stream window"};
+  }
+
+  // Streams hold back matches with MATCH_NOT_EOL and friends
+  if (regex->GetEngine() == RegexEngine::kRe2) {
+    throw std::invalid_argument{"Streams need a REGEX_STD pattern"};
+  }
+
+  auto regex_stream =
+      std::make_shared<RegexStream>(regex, window, GetMatchFlag(flags));
+
+  AddMemory(MemoryKind::kRegex, regex_stream->GetMemorySize());
+
+  return regex_streams_.Add(std::move(regex_stream));
+}
+
+// native RegexStream_Delete(&RegexStream:stream);
+cell Script::RegexStream_Delete(cell *regex_stream) {
+  RemoveMemory(MemoryKind::kRegex,
+               GetRegexStream(*regex_stream)->GetMemorySize());
+
+  regex_streams_.Remove(*regex_stream);
+
+  *regex_stream = 0;
+
+  return 1;
+}
+
+// native RegexStream_Feed(RegexStream:stream, const chunk[]);
+cell Script::RegexStream_Feed(RegexStreamPtr regex_stream, AmxString chunk) {
+  last_error_ = REGEX_ERROR_NONE;
+
+  // The buffer grows by at most the chunk. The matches it yields are counted
+  // afterwards, so once they are over a limit the next chunk is refused.
+  try {
+    CheckMemory(chunk.size());
+  } catch (const MemoryLimitError &) {
+    return SetLastError(REGEX_ERROR_LIMIT);
+  }
+
+  const auto bytes = regex_stream->GetMemorySize();
+
+  cell count{};
+
+  try {
+    count = regex_stream->Feed(chunk.view());
+  } catch (const MatchTimeout &) {
+    SetLastError(REGEX_ERROR_TIMEOUT);
+  }
+
+  ResizeMemory(MemoryKind::kRegex, bytes, regex_stream->GetMemorySize());
+
+  return count;
+}
+
+// native RegexStream_Finish(RegexStream:stream);
+cell Script::RegexStream_Finish(RegexStreamPtr regex_stream) {
+  last_error_ = REGEX_ERROR_NONE;
+
+  const auto bytes = regex_stream->GetMemorySize();
+
+  cell count{};
+
+  try {
+    count = regex_stream->Finish();
+  } catch (const MatchTimeout &) {
+    SetLastError(REGEX_ERROR_TIMEOUT);
+  }
+
+  ResizeMemory(MemoryKind::kRegex, bytes, regex_stream->GetMemorySize());
+
+  return count;
+}
+
+// native RegexStream_Next(RegexStream:stream, &RegexMatch:m, &pos);
+cell Script::RegexStream_Next(RegexStreamPtr regex_stream, cell *match_results,
+                              cell *pos) {
+  last_error_ = REGEX_ERROR_NONE;
+
+  const auto match = regex_stream->Front();
+  if (!match) {
+    return 0;
+  }
+
+  // The match stays queued if the script cannot hold it
+  try {
+    *match_results = AddMatchResults(match->results);
+  } catch (const MemoryLimitError &) {
+    return SetLastError(REGEX_ERROR_LIMIT);
+  }
+
+  *pos = match->pos;
+
+  const auto bytes = regex_stream->GetMemorySize();
+
+  regex_stream->Pop();
+
+  ResizeMemory(MemoryKind::kRegex, bytes, regex_stream->GetMemorySize());
 
   return 1;
 }
@@ -92,15 +823,47 @@ cell Script::Regex_Replace(std::string str, RegexPtr regex, std::string fmt,
 // dest);
 cell Script::Match_GetGroup(MatchResultsPtr match_results, cell index,
                             cell *dest, cell *length, cell size) {
-  const auto str = match_results->at(index);
+  const auto str = match_results->GetGroupString(index);
 
-  SetString(dest, str, size);
+  SetAmxString(dest, str, size);
 
   *length = str.length();
 
   return 1;
 }
 
+// native Match_GetNamedGroup(RegexMatch:m, const name[], dest[], &length,
+// size = sizeof dest);
+cell Script::Match_GetNamedGroup(MatchResultsPtr match_results,
+                                 AmxString name, cell *dest, cell *length,
+                                 cell size) {
+  return Match_GetGroup(match_results,
+                        match_results->GetGroupIndex(name.view()), dest,
+                        length, size);
+}
+
+// native Match_GetGroupPos(RegexMatch:m, index, &start, &length);
+cell Script::Match_GetGroupPos(MatchResultsPtr match_results, cell index,
+                               cell *start, cell *length) {
+  const auto &group = match_results->GetGroup(index);
+  if (!group.matched) {
+    *start = -1;
+    *length = 0;
+
+    return 0;
+  }
+
+  *start = group.offset;
+  *length = group.length;
+
+  return 1;
+}
+
+// native Match_GetGroupCount(RegexMatch:m);
+cell Script::Match_GetGroupCount(MatchResultsPtr match_results) {
+  return match_results->GetGroupCount();
+}
+
 // native Match_Free(&RegexMatch:m);
 cell Script::Match_Free(cell *match_results) {
   DeleteMatchResults(*match_results);
@@ -110,62 +873,347 @@ cell Script::Match_Free(cell *match_results) {
   return 1;
 }
 
-cell Script::NewRegex(const std::string &pattern,
-                      std::regex_constants::syntax_option_type option) {
-  const auto regex = std::make_shared<std::regex>();
+// native Match_FreeAll();
+cell Script::Match_FreeAll() {
+  const auto count = match_results_.Size();
 
-  regex->imbue(Plugin::Instance().GetLocale());
+  match_results_.Clear([this](MatchResultsPtr &&match_results) {
+    RecycleMatchResults(std::move(match_results));
+  });
 
-  regex->assign(pattern, option);
+  scoped_match_results_.clear();
 
-  regexes_.insert(regex);
+  return count;
+}
 
-  return reinterpret_cast<cell>(regex.get());
+// native Match_SetScoped(bool:scoped = true);
+cell Script::Match_SetScoped(cell scoped) {
+  scoped_ = scoped != 0;
+
+  return 1;
 }
 
-const RegexPtr &Script::GetRegex(cell ptr) {
-  const auto iter =
-      std::find_if(regexes_.begin(), regexes_.end(), [ptr](const RegexPtr &p) {
-        return p.get() == reinterpret_cast<void *>(ptr);
-      });
+// native Match_GetCount(&live, &peak);
+cell Script::Match_GetCount(cell *live, cell *peak) {
+  *live = match_results_.Size();
+  *peak = match_results_peak_;
+
+  return *live;
+}
+
+// native MatchList_Count(RegexMatchList:list);
+cell Script::MatchList_Count(MatchListPtr match_list) {
+  return match_list->GetMatchCount();
+}
+
+// native MatchList_GetGroup(RegexMatchList:list, match, index, dest[],
+// &length, size = sizeof dest);
+cell Script::MatchList_GetGroup(MatchListPtr match_list, cell match,
+                                cell index, cell *dest, cell *length,
+                                cell size) {
+  const auto str = match_list->GetGroupString(match, index);
+
+  SetAmxString(dest, str, size);
 
-  if (iter == regexes_.end()) {
+  *length = str.length();
+
+  return 1;
+}
+
+// native MatchList_GetGroupPos(RegexMatchList:list, match, index, &start,
+// &length);
+cell Script::MatchList_GetGroupPos(MatchListPtr match_list, cell match,
+                                   cell index, cell *start, cell *length) {
+  const auto &group = match_list->GetGroup(match, index);
+  if (!group.matched) {
+    *start = -1;
+    *length = 0;
+
+    return 0;
+  }
+
+  *start = group.offset;
+  *length = group.length;
+
+  return 1;
+}
+
+// native MatchList_Free(&RegexMatchList:list);
+cell Script::MatchList_Free(cell *match_list) {
+  RemoveMemory(MemoryKind::kMatch, GetMatchList(*match_list)->GetMemorySize());
+
+  match_lists_.Remove(*match_list);
+
+  *match_list = 0;
+
+  return 1;
+}
+
+cell Script::NewRegex(const std::string &pattern,
+                      std::regex_constants::syntax_option_type option,
+                      CharMode mode, RegexEngine engine) {
+  // Refuses before compiling and filling the cache
+  CheckMemory(MemoryKind::kRegex, 0);
+
+  return AddRegex(
+      Plugin::Instance().GetRegexCache().Get(pattern, option, mode, engine));
+}
+
+cell Script::AddRegex(RegexPtr regex) {
+  return AddRegex(
+      RegexRef{std::move(regex), Plugin::Instance().GetDefaultMatchLimit()});
+}
+
+cell Script::AddRegex(RegexRef regex) {
+  AddMemory(MemoryKind::kRegex, regex->GetMemorySize());
+
+  return regexes_.Add(std::move(regex));
+}
+
+const RegexRef &Script::GetRegex(cell handle) {
+  const auto regex = regexes_.Find(handle);
+  if (!regex) {
     throw std::runtime_error{"Invalid regex handle"};
   }
 
-  return *iter;
+  return *regex;
+}
+
+void Script::DeleteRegex(cell regex) {
+  RemoveMemory(MemoryKind::kRegex, GetRegex(regex)->GetMemorySize());
+
+  regexes_.Remove(regex);
+}
+
+const RegexSetPtr &Script::GetRegexSet(cell handle) {
+  const auto regex_set = regex_sets_.Find(handle);
+  if (!regex_set) {
+    throw std::runtime_error{"Invalid regex set handle"};
+  }
+
+  return *regex_set;
+}
+
+const RegexStreamPtr &Script::GetRegexStream(cell handle) {
+  const auto regex_stream = regex_streams_.Find(handle);
+  if (!regex_stream) {
+    throw std::runtime_error{"Invalid regex stream handle"};
+  }
+
+  return *regex_stream;
+}
+
+const MatchListPtr &Script::GetMatchList(cell handle) {
+  const auto match_list = match_lists_.Find(handle);
+  if (!match_list) {
+    throw std::runtime_error{"Invalid match list handle"};
+  }
+
+  return *match_list;
 }
 
-void Script::DeleteRegex(cell regex) { regexes_.erase(GetRegex(regex)); }
+cell Script::NewMatchResults(const char *first, const char *last,
+                             const SubjectMatch &match, const Regex &regex) {
+  MatchResultsPtr match_results;
 
-cell Script::NewMatchResults(const std::smatch &match) {
-  auto match_results = std::make_shared<MatchResults>();
+  if (match_results_pool_.empty()) {
+    match_results = std::make_shared<MatchResults>();
+  } else {
+    match_results = std::move(match_results_pool_.back());
 
-  for (const auto &item : match) {
-    match_results->push_back(item.str());
+    match_results_pool_.pop_back();
   }
 
-  match_results_.insert(match_results);
+  match_results->Assign(first, last, match);
+
+  match_results->SetGroupNames(regex.GetGroupNames());
 
-  return reinterpret_cast<cell>(match_results.get());
+  return AddMatchResults(std::move(match_results));
 }
 
-const MatchResultsPtr &Script::GetMatchResults(cell ptr) {
-  const auto iter =
-      std::find_if(match_results_.begin(), match_results_.end(),
-                   [ptr](const MatchResultsPtr &p) {
-                     return p.get() == reinterpret_cast<void *>(ptr);
-                   });
+cell Script::AddMatchResults(MatchResultsPtr match_results) {
+  AddMemory(MemoryKind::kMatch, match_results->GetMemorySize());
 
-  if (iter == match_results_.end()) {
+  const auto handle = match_results_.Add(std::move(match_results));
+
+  match_results_peak_ = std::max(match_results_peak_, match_results_.Size());
+
+  if (scoped_) {
+    if (scoped_match_results_.empty()) {
+      Plugin::Instance().AddScopedScript(this);
+    }
+
+    scoped_match_results_.push_back(handle);
+  }
+
+  return handle;
+}
+
+const MatchResultsPtr &Script::GetMatchResults(cell handle) {
+  const auto match_results = match_results_.Find(handle);
+  if (!match_results) {
     throw std::runtime_error{"Invalid match_results handle"};
   }
 
-  return *iter;
+  return *match_results;
 }
 
 void Script::DeleteMatchResults(cell match_results) {
-  match_results_.erase(GetMatchResults(match_results));
+  GetMatchResults(match_results);
+
+  RecycleMatchResults(match_results_.Remove(match_results));
+}
+
+void Script::RecycleMatchResults(MatchResultsPtr &&match_results) {
+  // A scoped handle may have been freed already
+  if (!match_results) {
+    return;
+  }
+
+  RemoveMemory(MemoryKind::kMatch, match_results->GetMemorySize());
+
+  // Results still referenced elsewhere (e.g. by a native that is running)
+  // are simply released
+  if (match_results.use_count() != 1 ||
+      match_results_pool_.size() >= kMaxPooledMatchResults) {
+    return;
+  }
+
+  match_results_pool_.push_back(std::move(match_results));
+}
+
+void Script::FreeScopedMatchResults() {
+  for (const auto handle : scoped_match_results_) {
+    RecycleMatchResults(match_results_.Remove(handle));
+  }
+
+  scoped_match_results_.clear();
+}
+
+void Script::CheckMemory(MemoryKind kind, std::size_t bytes) const {
+  const auto &limits = Plugin::Instance().GetMemoryLimits();
+
+  const auto max_count =
+      kind == MemoryKind::kRegex ? limits.regexes : limits.matches;
+  if (max_count && memory_usage_.GetCount(kind) >= max_count) {
+    throw MemoryLimitError{kind == MemoryKind::kRegex
+                               ? "Regex limit reached"
+                               : "Match limit reached"};
+  }
+
+  CheckMemory(bytes);
+}
+
+void Script::CheckMemory(std::size_t bytes) const {
+  auto &plugin = Plugin::Instance();
+
+  const auto &limits = plugin.GetMemoryLimits();
+
+  if (limits.bytes && memory_usage_.GetBytes() + bytes > limits.bytes) {
+    throw MemoryLimitError{"Memory limit reached"};
+  }
+
+  const auto &total = plugin.GetMemoryUsage();
+  if (limits.total_bytes && total.GetBytes() + bytes > limits.total_bytes) {
+    throw MemoryLimitError{"Total memory limit reached"};
+  }
+}
+
+void Script::AddMemory(MemoryKind kind, std::size_t bytes) {
+  CheckMemory(kind, bytes);
+
+  memory_usage_.Add(kind, bytes);
+
+  Plugin::Instance().GetMemoryUsage().Add(kind, bytes);
+}
+
+void Script::RemoveMemory(MemoryKind kind, std::size_t bytes) {
+  memory_usage_.Remove(kind, bytes);
+
+  Plugin::Instance().GetMemoryUsage().Remove(kind, bytes);
+}
+
+void Script::ResizeMemory(MemoryKind kind, std::size_t old_bytes,
+                          std::size_t new_bytes) {
+  memory_usage_.Resize(kind, old_bytes, new_bytes);
+
+  Plugin::Instance().GetMemoryUsage().Resize(kind, old_bytes, new_bytes);
+}
+
+cell Script::SetLastError(E_REGEX_ERROR error) {
+  last_error_ = error;
+
+  return 0;
+}
+
+void Script::RunBatch(
+    std::size_t count,
+    const std::function<void(std::size_t, std::size_t)> &func) {
+  auto &plugin = Plugin::Instance();
+
+  const auto threshold = plugin.GetBatchParallelThreshold();
+  if (!threshold || count <= threshold) {
+    func(0, count);
+
+    return;
+  }
+
+  plugin.GetWorkerPool().ParallelFor(count, threshold / 2, func);
+}
+
+// forward Callback(data, RegexMatch:m, pos);
+void Script::CompleteSearchAsync(const std::string &callback, cell data,
+                                 const MatchResultsPtr &match_results) {
+  const auto amx = GetAmx();
+
+  int index{};
+  if (amx_FindPublic(amx, callback.c_str(), &index) != AMX_ERR_NONE) {
+    throw std::runtime_error{"Callback " + callback + " not found"};
+  }
+
+  last_error_ = REGEX_ERROR_NONE;
+
+  // The match only lives for the duration of the callback. A script that
+  // cannot hold it gets no match and REGEX_ERROR_LIMIT.
+  cell handle{};
+  if (match_results) {
+    try {
+      handle = AddMatchResults(match_results);
+    } catch (const MemoryLimitError &) {
+      SetLastError(REGEX_ERROR_LIMIT);
+    }
+  }
+
+  amx_Push(amx, handle ? match_results->GetGroup(0).offset : -1);
+  amx_Push(amx, handle);
+  amx_Push(amx, data);
+
+  amx_Exec(amx, nullptr, index);
+
+  if (handle) {
+    RecycleMatchResults(match_results_.Remove(handle));
+  }
+}
+
+// forward Callback(data, const result[], length);
+void Script::CompleteReplaceAsync(const std::string &callback, cell data,
+                                  const std::string &result) {
+  const auto amx = GetAmx();
+
+  int index{};
+  if (amx_FindPublic(amx, callback.c_str(), &index) != AMX_ERR_NONE) {
+    throw std::runtime_error{"Callback " + callback + " not found"};
+  }
+
+  cell addr{};
+
+  amx_Push(amx, result.length());
+  amx_PushString(amx, &addr, nullptr, result.c_str(), 0, 0);
+  amx_Push(amx, data);
+
+  amx_Exec(amx, nullptr, index);
+
+  amx_Release(amx, addr);
 }
 
 std::regex_constants::syntax_option_type Script::GetRegexFlag(
@@ -201,6 +1249,34 @@ std::regex_constants::syntax_option_type Script::GetRegexFlag(
   return flag;
 }
 
+CharMode Script::GetCharMode(E_REGEX_FLAG flags) {
+  if (flags & REGEX_UTF8) {
+    return CharMode::kUtf8;
+  }
+
+  if (flags & REGEX_BYTES) {
+    return CharMode::kBytes;
+  }
+
+  if (flags & REGEX_LOCALE) {
+    return CharMode::kLocale;
+  }
+
+  return Plugin::Instance().GetDefaultCharMode();
+}
+
+RegexEngine Script::GetEngine(E_REGEX_FLAG flags) {
+  if (flags & REGEX_RE2) {
+    return RegexEngine::kRe2;
+  }
+
+  if (flags & REGEX_STD) {
+    return RegexEngine::kStd;
+  }
+
+  return Plugin::Instance().GetDefaultEngine();
+}
+
 std::regex_constants::match_flag_type Script::GetMatchFlag(E_MATCH_FLAG flags) {
   const static std::unordered_map<std::size_t,
                                   std::regex_constants::match_flag_type>
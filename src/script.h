@@ -25,12 +25,10 @@
 #ifndef PAWNREGEX_SCRIPT_H_
 #define PAWNREGEX_SCRIPT_H_
 
-using RegexPtr = std::shared_ptr<std::regex>;
-using MatchResults = std::vector<std::string>;
-using MatchResultsPtr = std::shared_ptr<MatchResults>;
-
 class Script : public ptl::AbstractScript<Script> {
  public:
+  ~Script();
+
   const char *VarVersion() { return "_pawnregex_version"; }
 
   // native Regex:Regex_New(const pattern[], E_REGEX_FLAG:flags = REGEX_DEFAULT,
@@ -38,52 +36,277 @@ class Script : public ptl::AbstractScript<Script> {
   cell Regex_New(std::string pattern, E_REGEX_FLAG flags,
                  E_REGEX_GRAMMAR grammar);
 
+  // native Regex:Regex_Get(const name[]);
+  cell Regex_Get(std::string name);
+
   // native Regex_Delete(&Regex:r);
   cell Regex_Delete(cell *regex);
 
+  // native Regex_Share(Regex:r, const name[]);
+  cell Regex_Share(RegexRef regex, std::string name);
+
+  // native Regex:Regex_Import(const name[]);
+  cell Regex_Import(std::string name);
+
+  // native Regex_Unshare(const name[]);
+  cell Regex_Unshare(std::string name);
+
   // native Regex_Check(const str[], Regex:r, E_MATCH_FLAG:flags =
   // MATCH_DEFAULT);
-  cell Regex_Check(std::string str, RegexPtr regex, E_MATCH_FLAG flags);
+  cell Regex_Check(AmxString str, RegexRef regex, E_MATCH_FLAG flags);
 
   // native Regex_Match(const str[], Regex:r, &RegexMatch:m, E_MATCH_FLAG:flags
   // = MATCH_DEFAULT);
-  cell Regex_Match(std::string str, RegexPtr regex, cell *match_results,
+  cell Regex_Match(AmxString str, RegexRef regex, cell *match_results,
                    E_MATCH_FLAG flags);
 
   // native Regex_Search(const str[], Regex:r, &RegexMatch:m, &pos, startpos =
   // 0, E_MATCH_FLAG:flags = MATCH_DEFAULT);
-  cell Regex_Search(std::string str, RegexPtr regex, cell *match_results,
+  cell Regex_Search(AmxString str, RegexRef regex, cell *match_results,
                     cell *pos, cell startpos, E_MATCH_FLAG flags);
 
   // native Regex_Replace(const str[], Regex:r, const fmt[], dest[],
   // E_MATCH_FLAG:flags = MATCH_DEFAULT, size = sizeof dest);
-  cell Regex_Replace(std::string str, RegexPtr regex, std::string fmt,
+  cell Regex_Replace(AmxString str, RegexRef regex, AmxString fmt,
                      cell *dest, E_MATCH_FLAG flags, cell size);
 
+  // native Regex_ReplaceEx(const str[], Regex:r, const fmt[], dest[], &needed,
+  // &replacements, E_MATCH_FLAG:flags = MATCH_DEFAULT, size = sizeof dest);
+  cell Regex_ReplaceEx(AmxString str, RegexRef regex, AmxString fmt,
+                       cell *dest, cell *needed, cell *replacements,
+                       E_MATCH_FLAG flags, cell size);
+
+  // native Regex_SearchAsync(const str[], Regex:r, const callback[], data = 0,
+  // startpos = 0, E_MATCH_FLAG:flags = MATCH_DEFAULT);
+  cell Regex_SearchAsync(AmxString str, RegexRef regex, std::string callback,
+                         cell data, cell startpos, E_MATCH_FLAG flags);
+
+  // native Regex_ReplaceAsync(const str[], Regex:r, const fmt[],
+  // const callback[], data = 0, E_MATCH_FLAG:flags = MATCH_DEFAULT);
+  cell Regex_ReplaceAsync(AmxString str, RegexRef regex, AmxString fmt,
+                          std::string callback, cell data,
+                          E_MATCH_FLAG flags);
+
+  // native Regex_SearchAll(const str[], Regex:r, &RegexMatchList:list,
+  // E_MATCH_FLAG:flags = MATCH_DEFAULT);
+  cell Regex_SearchAll(AmxString str, RegexRef regex, cell *match_list,
+                       E_MATCH_FLAG flags);
+
+  // native Regex_SearchAllPos(const str[], Regex:r, spans[], &count,
+  // E_MATCH_FLAG:flags = MATCH_DEFAULT, size = sizeof spans);
+  cell Regex_SearchAllPos(AmxString str, RegexRef regex, cell *spans,
+                          cell *count, E_MATCH_FLAG flags, cell size);
+
+  // native Regex_CheckMany(const strings[][], count, Regex:r, results[],
+  // E_MATCH_FLAG:flags = MATCH_DEFAULT, size = sizeof results, rows = sizeof
+  // strings);
+  cell Regex_CheckMany(cell *strings, cell count, RegexRef regex,
+                       cell *results, E_MATCH_FLAG flags, cell size,
+                       cell rows);
+
+  // native Regex_ReplaceMany(const strings[][], count, Regex:r, const fmt[],
+  // dest[][], E_MATCH_FLAG:flags = MATCH_DEFAULT, size = sizeof dest[], rows =
+  // sizeof strings, dest_rows = sizeof dest);
+  cell Regex_ReplaceMany(cell *strings, cell count, RegexRef regex,
+                         AmxString fmt, cell *dest, E_MATCH_FLAG flags,
+                         cell size, cell rows, cell dest_rows);
+
+  // native Regex_CheckP(const str[], const pattern[], E_MATCH_FLAG:flags =
+  // MATCH_DEFAULT, E_REGEX_FLAG:regex_flags = REGEX_DEFAULT,
+  // E_REGEX_GRAMMAR:grammar = REGEX_ECMASCRIPT);
+  cell Regex_CheckP(AmxString str, AmxString pattern, E_MATCH_FLAG flags,
+                    E_REGEX_FLAG regex_flags, E_REGEX_GRAMMAR grammar);
+
+  // native Regex_ReplaceP(const str[], const pattern[], const fmt[], dest[],
+  // E_MATCH_FLAG:flags = MATCH_DEFAULT, E_REGEX_FLAG:regex_flags =
+  // REGEX_DEFAULT, E_REGEX_GRAMMAR:grammar = REGEX_ECMASCRIPT, size = sizeof
+  // dest);
+  cell Regex_ReplaceP(AmxString str, AmxString pattern, AmxString fmt,
+                      cell *dest, E_MATCH_FLAG flags, E_REGEX_FLAG regex_flags,
+                      E_REGEX_GRAMMAR grammar, cell size);
+
+  // native Regex_GetCacheStats(&hits, &misses, &evictions);
+  cell Regex_GetCacheStats(cell *hits, cell *misses, cell *evictions);
+
+  // native Regex_GetGroupIndex(Regex:r, const name[]);
+  cell Regex_GetGroupIndex(RegexRef regex, AmxString name);
+
+  // native Regex_SetLimit(Regex:r, microseconds, steps);
+  cell Regex_SetLimit(cell regex, cell microseconds, cell steps);
+
+  // native Regex_GetTimeoutCount(Regex:r);
+  cell Regex_GetTimeoutCount(RegexRef regex);
+
+  // native E_REGEX_ERROR:Regex_GetLastError();
+  cell Regex_GetLastError();
+
+  // native Regex_GetStats(Regex:r, &calls, &matches, &misses, &total_us,
+  // &max_us, &compile_us);
+  cell Regex_GetStats(RegexRef regex, cell *calls, cell *matches, cell *misses,
+                      cell *total_us, cell *max_us, cell *compile_us);
+
+  // native Regex_GetLengthHistogram(Regex:r, buckets[], size = sizeof
+  // buckets);
+  cell Regex_GetLengthHistogram(RegexRef regex, cell *buckets, cell size);
+
+  // native Regex_DumpStats();
+  cell Regex_DumpStats();
+
+  // native Regex_GetMemoryUsage(&regexes, &regex_bytes, &matches,
+  // &match_bytes, bool:peak = false, bool:global = false);
+  cell Regex_GetMemoryUsage(cell *regexes, cell *regex_bytes, cell *matches,
+                            cell *match_bytes, cell peak, cell global);
+
+  // native RegexSet:RegexSet_New();
+  cell RegexSet_New();
+
+  // native RegexSet_Delete(&RegexSet:set);
+  cell RegexSet_Delete(cell *regex_set);
+
+  // native RegexSet_Add(RegexSet:set, const pattern[], E_REGEX_FLAG:flags =
+  // REGEX_DEFAULT, E_REGEX_GRAMMAR:grammar = REGEX_ECMASCRIPT);
+  cell RegexSet_Add(cell regex_set, std::string pattern, E_REGEX_FLAG flags,
+                    E_REGEX_GRAMMAR grammar);
+
+  // native RegexSet_Compile(RegexSet:set);
+  cell RegexSet_Compile(RegexSetPtr regex_set);
+
+  // native RegexSet_Match(const str[], RegexSet:set, matched_ids[], &count,
+  // E_MATCH_FLAG:flags = MATCH_DEFAULT, size = sizeof matched_ids);
+  cell RegexSet_Match(AmxString str, RegexSetPtr regex_set, cell *matched_ids,
+                      cell *count, E_MATCH_FLAG flags, cell size);
+
+  // native RegexStream:RegexStream_New(Regex:r, window = 256,
+  // E_MATCH_FLAG:flags = MATCH_DEFAULT);
+  cell RegexStream_New(RegexRef regex, cell window, E_MATCH_FLAG flags);
+
+  // native RegexStream_Delete(&RegexStream:stream);
+  cell RegexStream_Delete(cell *regex_stream);
+
+  // native RegexStream_Feed(RegexStream:stream, const chunk[]);
+  cell RegexStream_Feed(RegexStreamPtr regex_stream, AmxString chunk);
+
+  // native RegexStream_Finish(RegexStream:stream);
+  cell RegexStream_Finish(RegexStreamPtr regex_stream);
+
+  // native RegexStream_Next(RegexStream:stream, &RegexMatch:m, &pos);
+  cell RegexStream_Next(RegexStreamPtr regex_stream, cell *match_results,
+                        cell *pos);
+
   // native Match_GetGroup(RegexMatch:m, index, dest[], &length, size = sizeof
   // dest);
   cell Match_GetGroup(MatchResultsPtr match_results, cell index, cell *dest,
                       cell *length, cell size);
 
+  // native Match_GetNamedGroup(RegexMatch:m, const name[], dest[], &length,
+  // size = sizeof dest);
+  cell Match_GetNamedGroup(MatchResultsPtr match_results, AmxString name,
+                           cell *dest, cell *length, cell size);
+
+  // native Match_GetGroupPos(RegexMatch:m, index, &start, &length);
+  cell Match_GetGroupPos(MatchResultsPtr match_results, cell index,
+                         cell *start, cell *length);
+
+  // native Match_GetGroupCount(RegexMatch:m);
+  cell Match_GetGroupCount(MatchResultsPtr match_results);
+
   // native Match_Free(&RegexMatch:m);
   cell Match_Free(cell *match_results);
 
+  // native Match_FreeAll();
+  cell Match_FreeAll();
+
+  // native Match_SetScoped(bool:scoped = true);
+  cell Match_SetScoped(cell scoped);
+
+  // native Match_GetCount(&live, &peak);
+  cell Match_GetCount(cell *live, cell *peak);
+
+  // native MatchList_Count(RegexMatchList:list);
+  cell MatchList_Count(MatchListPtr match_list);
+
+  // native MatchList_GetGroup(RegexMatchList:list, match, index, dest[],
+  // &length, size = sizeof dest);
+  cell MatchList_GetGroup(MatchListPtr match_list, cell match, cell index,
+                          cell *dest, cell *length, cell size);
+
+  // native MatchList_GetGroupPos(RegexMatchList:list, match, index, &start,
+  // &length);
+  cell MatchList_GetGroupPos(MatchListPtr match_list, cell match, cell index,
+                             cell *start, cell *length);
+
+  // native MatchList_Free(&RegexMatchList:list);
+  cell MatchList_Free(cell *match_list);
+
   cell NewRegex(const std::string &pattern,
-                std::regex_constants::syntax_option_type option);
-  const RegexPtr &GetRegex(cell ptr);
+                std::regex_constants::syntax_option_type option, CharMode mode,
+                RegexEngine engine);
+  // With the MatchTimeLimit and MatchStepLimit from the config
+  cell AddRegex(RegexPtr regex);
+  cell AddRegex(RegexRef regex);
+  const RegexRef &GetRegex(cell handle);
   void DeleteRegex(cell regex);
 
-  cell NewMatchResults(const std::smatch &match);
-  const MatchResultsPtr &GetMatchResults(cell ptr);
+  const RegexSetPtr &GetRegexSet(cell handle);
+
+  const RegexStreamPtr &GetRegexStream(cell handle);
+
+  const MatchListPtr &GetMatchList(cell handle);
+
+  cell NewMatchResults(const char *first, const char *last,
+                       const SubjectMatch &match, const Regex &regex);
+  cell AddMatchResults(MatchResultsPtr match_results);
+  const MatchResultsPtr &GetMatchResults(cell handle);
   void DeleteMatchResults(cell match_results);
+  void RecycleMatchResults(MatchResultsPtr &&match_results);
+  void FreeScopedMatchResults();
 
-  std::regex_constants::syntax_option_type GetRegexFlag(
+  // Throws MemoryLimitError if one more handle of bytes would exceed a limit
+  // from pawnregex.cfg
+  void CheckMemory(MemoryKind kind, std::size_t bytes) const;
+  // The same for bytes more held by the handles already counted
+  void CheckMemory(std::size_t bytes) const;
+  void AddMemory(MemoryKind kind, std::size_t bytes);
+  void RemoveMemory(MemoryKind kind, std::size_t bytes);
+  void ResizeMemory(MemoryKind kind, std::size_t old_bytes,
+                    std::size_t new_bytes);
+
+  // Records why the native failed and returns 0
+  cell SetLastError(E_REGEX_ERROR error);
+
+  // Runs func(first, last) over the rows [0, count) of a batch, splitting it
+  // across the worker threads when it is large enough
+  void RunBatch(std::size_t count,
+                const std::function<void(std::size_t, std::size_t)> &func);
+
+  void CompleteSearchAsync(const std::string &callback, cell data,
+                           const MatchResultsPtr &match_results);
+  void CompleteReplaceAsync(const std::string &callback, cell data,
+                            const std::string &result);
+
+  static std::regex_constants::syntax_option_type GetRegexFlag(
       E_REGEX_FLAG flags, E_REGEX_GRAMMAR grammar);
+  static CharMode GetCharMode(E_REGEX_FLAG flags);
+  static RegexEngine GetEngine(E_REGEX_FLAG flags);
   std::regex_constants::match_flag_type GetMatchFlag(E_MATCH_FLAG flags);
 
  private:
-  std::unordered_set<RegexPtr> regexes_;
-  std::unordered_set<MatchResultsPtr> match_results_;
+  static constexpr std::size_t kMaxPooledMatchResults = 256;
+
+  HandleTable<RegexRef> regexes_;
+  HandleTable<MatchResultsPtr> match_results_;
+  HandleTable<RegexSetPtr> regex_sets_;
+  HandleTable<RegexStreamPtr> regex_streams_;
+  HandleTable<MatchListPtr> match_lists_;
+  std::vector<MatchResultsPtr> match_results_pool_;
+  std::vector<cell> scoped_match_results_;
+  std::size_t match_results_peak_{};
+  MemoryUsage memory_usage_;
+  E_REGEX_ERROR last_error_{REGEX_ERROR_NONE};
+  bool scoped_{};
+
+  // Lets async jobs that outlive the script find out it is gone
+  std::shared_ptr<bool> alive_ = std::make_shared<bool>(true);
 };
 
 #endif  // PAWNREGEX_SCRIPT_H_
@@ -0,0 +1,109 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PAWNREGEX_UTF8_H_
+#define PAWNREGEX_UTF8_H_
+
+// What bytes that are not valid UTF-8 decode to, and code points that do not
+// fit in wchar_t (everything past U+FFFF on Windows)
+constexpr wchar_t kReplacementChar = 0xFFFD;
+
+// Decodes the character at first, which must be below last, into ch and
+// returns the number of bytes it takes. A byte that does not start a valid
+// sequence is read as one kReplacementChar.
+inline std::size_t DecodeUtf8(const char *first, const char *last,
+                              wchar_t &ch) {
+  const auto lead = static_cast<unsigned char>(*first);
+  if (lead < 0x80) {
+    ch = lead;
+
+    return 1;
+  }
+
+  // The bounds of the second byte rule out overlong forms, surrogates and
+  // code points past U+10FFFF
+  std::size_t length{};
+  std::uint32_t code{};
+  unsigned char min = 0x80, max = 0xBF;
+
+  if (lead >= 0xC2 && lead <= 0xDF) {
+    length = 2;
+    code = lead & 0x1F;
+  } else if (lead >= 0xE0 && lead <= 0xEF) {
+    length = 3;
+    code = lead & 0x0F;
+    min = lead == 0xE0 ? 0xA0 : 0x80;
+    max = lead == 0xED ? 0x9F : 0xBF;
+  } else if (lead >= 0xF0 && lead <= 0xF4) {
+    length = 4;
+    code = lead & 0x07;
+    min = lead == 0xF0 ? 0x90 : 0x80;
+    max = lead == 0xF4 ? 0x8F : 0xBF;
+  }
+
+  ch = kReplacementChar;
+
+  if (!length || static_cast<std::size_t>(last - first) < length) {
+    return 1;
+  }
+
+  for (std::size_t i = 1; i < length; ++i) {
+    const auto byte = static_cast<unsigned char>(first[i]);
+    if (byte < min || byte > max) {
+      return 1;
+    }
+
+    code = (code << 6) | (byte & 0x3F);
+
+    min = 0x80;
+    max = 0xBF;
+  }
+
+  if (code <=
+      static_cast<std::uint32_t>(std::numeric_limits<wchar_t>::max())) {
+    ch = static_cast<wchar_t>(code);
+  }
+
+  return length;
+}
+
+inline std::wstring DecodeUtf8(std::string_view str) {
+  std::wstring result;
+
+  result.reserve(str.size());
+
+  const auto last = str.data() + str.size();
+
+  for (auto first = str.data(); first != last;) {
+    wchar_t ch{};
+
+    first += DecodeUtf8(first, last, ch);
+
+    result.push_back(ch);
+  }
+
+  return result;
+}
+
+#endif  // PAWNREGEX_UTF8_H_
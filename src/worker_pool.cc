@@ -0,0 +1,166 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "main.h"
+
+void WorkerPool::Start(std::size_t thread_count) {
+  Stop();
+
+  stopping_ = false;
+
+  for (std::size_t i{}; i < thread_count; ++i) {
+    threads_.emplace_back(&WorkerPool::Run, this);
+  }
+}
+
+void WorkerPool::Stop() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+
+    stopping_ = true;
+  }
+
+  condition_.notify_all();
+
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+
+  threads_.clear();
+}
+
+void WorkerPool::Push(std::function<void()> task) {
+  if (threads_.empty()) {
+    task();
+
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+
+    tasks_.push_back(std::move(task));
+  }
+
+  condition_.notify_one();
+}
+
+void WorkerPool::ParallelFor(
+    std::size_t count, std::size_t min_chunk,
+    const std::function<void(std::size_t, std::size_t)> &func) {
+  min_chunk = std::max<std::size_t>(min_chunk, 1);
+
+  // A few chunks per thread even out rows that take longer than others
+  const auto max_chunks = (threads_.size() + 1) * 4;
+  const auto chunk_size =
+      std::max(min_chunk, (count + max_chunks - 1) / max_chunks);
+  const auto chunk_count = (count + chunk_size - 1) / chunk_size;
+
+  if (threads_.empty() || chunk_count <= 1) {
+    func(0, count);
+
+    return;
+  }
+
+  // Helpers that start after every chunk has been taken only touch the
+  // shared state, so the caller may return before they run
+  struct State {
+    std::atomic<std::size_t> next_chunk{};
+    std::size_t done_chunks{};
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable condition;
+  };
+
+  const auto state = std::make_shared<State>();
+
+  const auto run_chunks = [state, &func, count, chunk_size, chunk_count] {
+    for (;;) {
+      const auto chunk = state->next_chunk++;
+      if (chunk >= chunk_count) {
+        return;
+      }
+
+      const auto first = chunk * chunk_size;
+
+      std::exception_ptr error;
+
+      try {
+        func(first, std::min(count, first + chunk_size));
+      } catch (...) {
+        error = std::current_exception();
+      }
+
+      std::lock_guard<std::mutex> lock{state->mutex};
+
+      if (error && !state->error) {
+        state->error = error;
+      }
+
+      if (++state->done_chunks == chunk_count) {
+        state->condition.notify_all();
+      }
+    }
+  };
+
+  const auto helper_count = std::min(threads_.size(), chunk_count - 1);
+
+  for (std::size_t i{}; i < helper_count; ++i) {
+    Push(run_chunks);
+  }
+
+  run_chunks();
+
+  std::unique_lock<std::mutex> lock{state->mutex};
+
+  state->condition.wait(lock, [&state, chunk_count] {
+    return state->done_chunks == chunk_count;
+  });
+
+  if (state->error) {
+    std::rethrow_exception(state->error);
+  }
+}
+
+void WorkerPool::Run() {
+  for (;;) {
+    std::function<void()> task;
+
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+
+      condition_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+
+      if (tasks_.empty()) {
+        return;
+      }
+
+      task = std::move(tasks_.front());
+
+      tasks_.pop_front();
+    }
+
+    task();
+  }
+}
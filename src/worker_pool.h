@@ -0,0 +1,58 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PAWNREGEX_WORKER_POOL_H_
+#define PAWNREGEX_WORKER_POOL_H_
+
+// Fixed-size thread pool. With WorkerThreads = 0 tasks run in Push.
+class WorkerPool {
+ public:
+  ~WorkerPool() { Stop(); }
+
+  void Start(std::size_t thread_count);
+
+  // Finishes the queued tasks and joins the threads
+  void Stop();
+
+  void Push(std::function<void()> task);
+
+  // Runs func(first, last) over [0, count) on the threads and the caller.
+  // Rethrows the first exception.
+  void ParallelFor(
+      std::size_t count, std::size_t min_chunk,
+      const std::function<void(std::size_t, std::size_t)> &func);
+
+  std::size_t GetThreadCount() const { return threads_.size(); }
+
+ private:
+  void Run();
+
+  std::vector<std::thread> threads_;
+  std::deque<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool stopping_{};
+};
+
+#endif  // PAWNREGEX_WORKER_POOL_H_
@@ -0,0 +1,305 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "fake_amx.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+// Runs func in batches until min_time has passed and prints the average time
+// of one call as CSV
+template <typename Func>
+void Run(const char *filter, const char *name, Func func) {
+  using Clock = std::chrono::steady_clock;
+
+  constexpr auto kMinTime = std::chrono::milliseconds{500};
+
+  if (filter && !std::strstr(name, filter)) {
+    return;
+  }
+
+  // Warm up the caches, pools and thread-local buffers
+  for (int i{}; i < 100; ++i) {
+    func();
+  }
+
+  std::size_t iterations{};
+  std::size_t batch = 16;
+
+  const auto start = Clock::now();
+  auto elapsed = Clock::duration{};
+
+  while (elapsed < kMinTime) {
+    for (std::size_t i{}; i < batch; ++i) {
+      func();
+    }
+
+    iterations += batch;
+    batch *= 2;
+
+    elapsed = Clock::now() - start;
+  }
+
+  std::printf(
+      "%s,%zu,%.1f\n", name, iterations,
+      std::chrono::duration<double, std::nano>{elapsed}.count() / iterations);
+}
+
+cell NewRegex(FakeAmx &amx, const char *pattern, int flags = REGEX_DEFAULT) {
+  const auto mark = amx.GetHeapMark();
+
+  const auto regex =
+      amx.Call("Regex_New", amx.String(pattern), flags, REGEX_ECMASCRIPT);
+
+  amx.Release(mark);
+
+  return regex;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const char *filter = argc > 1 ? argv[1] : nullptr;
+
+  static FakeAmx amx;
+
+  std::printf("name,iterations,ns_per_op\n");
+
+  {
+    const auto regex = NewRegex(amx, "[A-Z][a-z]+_[A-Z][a-z]+");
+    const auto valid = amx.String("Firstname_Lastname");
+    const auto invalid = amx.String("firstname.lastname");
+
+    Run(filter, "nickname_check", [&] {
+      amx.Call("Regex_Check", valid, regex, MATCH_DEFAULT);
+      amx.Call("Regex_Check", invalid, regex, MATCH_DEFAULT);
+    });
+  }
+
+  {
+    constexpr std::size_t kRows = 1000;
+
+    const auto regex = NewRegex(amx, "[A-Z][a-z]+_[A-Z][a-z]+");
+
+    std::vector<std::string> names;
+    for (std::size_t i{}; i < kRows; ++i) {
+      names.push_back(i % 2 ? "Firstname_Lastname" + std::to_string(i)
+                            : "firstname.lastname" + std::to_string(i));
+    }
+
+    const auto strings = amx.StringArray(names);
+    const auto results = amx.Array(kRows);
+
+    Run(filter, "batch_check_loop", [&] {
+      for (std::size_t i{}; i < kRows; ++i) {
+        amx.At(results + i) = amx.Call("Regex_Check", amx.Row(strings, i),
+                                       regex, MATCH_DEFAULT);
+      }
+    });
+
+    Run(filter, "batch_check_many", [&] {
+      amx.Call("Regex_CheckMany", strings, kRows, regex, results,
+               MATCH_DEFAULT, kRows, kRows);
+    });
+  }
+
+  {
+    const auto locale = NewRegex(amx, "^[a-z]+_[a-z]+\\b", REGEX_ICASE);
+    const auto bytes =
+        NewRegex(amx, "^[a-z]+_[a-z]+\\b", REGEX_ICASE | REGEX_BYTES);
+    const auto utf8 =
+        NewRegex(amx, "^[a-z]+_[a-z]+\\b", REGEX_ICASE | REGEX_UTF8);
+    const auto str = amx.String("Firstname_Lastname");
+
+    Run(filter, "icase_check_locale",
+        [&] { amx.Call("Regex_Check", str, locale, MATCH_DEFAULT); });
+
+    Run(filter, "icase_check_bytes",
+        [&] { amx.Call("Regex_Check", str, bytes, MATCH_DEFAULT); });
+
+    Run(filter, "icase_check_utf8",
+        [&] { amx.Call("Regex_Check", str, utf8, MATCH_DEFAULT); });
+  }
+
+  {
+    const auto regex = NewRegex(amx, "^\\/(\\w+)\\s*(.+?)?\\s*$");
+    const auto cmdtext = amx.String("/givemoney 42 1000000");
+    const auto match = amx.Ref();
+    const auto dest = amx.Array(128);
+    const auto length = amx.Ref();
+
+    Run(filter, "command_parse", [&] {
+      if (amx.Call("Regex_Match", cmdtext, regex, match, MATCH_DEFAULT)) {
+        amx.Call("Match_GetGroup", amx.At(match), 1, dest, length, 128);
+        amx.Call("Match_GetGroup", amx.At(match), 2, dest, length, 128);
+        amx.Call("Match_Free", match);
+      }
+    });
+  }
+
+  {
+    const auto std_regex =
+        NewRegex(amx, "^\\/(\\w+)\\s*(.+?)?\\s*$", REGEX_STD);
+    const auto re2_regex =
+        NewRegex(amx, "^\\/(\\w+)\\s*(.+?)?\\s*$", REGEX_RE2);
+    const auto cmdtext = amx.String("/givemoney 42 1000000");
+    const auto match = amx.Ref();
+
+    Run(filter, "engine_match_std", [&] {
+      if (amx.Call("Regex_Match", cmdtext, std_regex, match, MATCH_DEFAULT)) {
+        amx.Call("Match_Free", match);
+      }
+    });
+
+    Run(filter, "engine_match_re2", [&] {
+      if (amx.Call("Regex_Match", cmdtext, re2_regex, match, MATCH_DEFAULT)) {
+        amx.Call("Match_Free", match);
+      }
+    });
+
+    // std::regex backtracks through every split of the "a"s
+    const auto std_nested = NewRegex(amx, "(a+)+$", REGEX_STD);
+    const auto re2_nested = NewRegex(amx, "(a+)+$", REGEX_RE2);
+    const auto str = amx.String(std::string(16, 'a') + "!");
+
+    Run(filter, "engine_nested_std",
+        [&] { amx.Call("Regex_Check", str, std_nested, MATCH_DEFAULT); });
+
+    Run(filter, "engine_nested_re2",
+        [&] { amx.Call("Regex_Check", str, re2_nested, MATCH_DEFAULT); });
+  }
+
+  {
+    constexpr std::size_t kPatterns = 64;
+
+    const auto set = amx.Call("RegexSet_New");
+    std::vector<cell> regexes;
+
+    for (std::size_t i{}; i < kPatterns; ++i) {
+      const auto pattern = "badword" + std::to_string(i) + "\\b";
+      const auto mark = amx.GetHeapMark();
+
+      amx.Call("RegexSet_Add", set, amx.String(pattern), REGEX_ICASE,
+               REGEX_ECMASCRIPT);
+
+      amx.Release(mark);
+
+      regexes.push_back(NewRegex(amx, pattern.c_str(), REGEX_ICASE));
+    }
+
+    amx.Call("RegexSet_Compile", set);
+
+    const auto message = amx.String(
+        "hey everyone, meet me at the bank in los santos, bring badword42 "
+        "and the car");
+    const auto ids = amx.Array(kPatterns);
+    const auto count = amx.Ref();
+    const auto match = amx.Ref();
+    const auto pos = amx.Ref();
+
+    Run(filter, "chat_filter_set", [&] {
+      amx.Call("RegexSet_Match", message, set, ids, count, MATCH_DEFAULT,
+               kPatterns);
+    });
+
+    Run(filter, "chat_filter_loop", [&] {
+      for (const auto regex : regexes) {
+        if (amx.Call("Regex_Search", message, regex, match, pos, 0,
+                     MATCH_DEFAULT)) {
+          amx.Call("Match_Free", match);
+        }
+      }
+    });
+  }
+
+  {
+    std::string text;
+    while (text.size() < 4096) {
+      text += "lorem   ipsum\tdolor  sit amet, ";
+    }
+
+    text.resize(4095);
+
+    const auto regex = NewRegex(amx, "\\s+");
+    const auto str = amx.String(text);
+    const auto fmt = amx.String(" ");
+    const auto dest = amx.Array(4096);
+
+    Run(filter, "bulk_replace_4k", [&] {
+      amx.Call("Regex_Replace", str, regex, fmt, dest, MATCH_DEFAULT, 4096);
+    });
+  }
+
+  {
+    const auto pattern = amx.String("^[a-z]+\\d*$");
+    const auto regex_ref = amx.Ref();
+
+    Run(filter, "regex_churn", [&] {
+      amx.At(regex_ref) =
+          amx.Call("Regex_New", pattern, REGEX_DEFAULT, REGEX_ECMASCRIPT);
+      amx.Call("Regex_Delete", regex_ref);
+    });
+
+    const auto regex = NewRegex(amx, "(\\w+)@(\\w+)");
+    const auto str = amx.String("user@example");
+    const auto match = amx.Ref();
+
+    Run(filter, "match_churn", [&] {
+      amx.Call("Regex_Match", str, regex, match, MATCH_DEFAULT);
+      amx.Call("Match_Free", match);
+    });
+  }
+
+  // The handle table alone, with 10 to 100k live handles
+  for (const std::size_t live : {10, 1000, 10000, 100000}) {
+    HandleTable<cell> table;
+
+    std::vector<cell> handles;
+    for (std::size_t i{}; i < live; ++i) {
+      handles.push_back(table.Add(static_cast<cell>(i)));
+    }
+
+    const auto suffix = std::to_string(live);
+
+    std::size_t next{};
+    volatile cell sink{};
+
+    Run(filter, ("handle_find_" + suffix).c_str(), [&] {
+      sink = *table.Find(handles[next]);
+      next = (next + 7919) % live;
+    });
+
+    Run(filter, ("handle_churn_" + suffix).c_str(), [&] {
+      table.Remove(handles[next]);
+      handles[next] = table.Add(static_cast<cell>(next));
+      next = (next + 7919) % live;
+    });
+  }
+
+  FakeAmx::Unload();
+
+  return 0;
+}
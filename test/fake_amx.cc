@@ -0,0 +1,490 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "fake_amx.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+PLUGIN_EXPORT bool PLUGIN_CALL Load(void **ppData);
+PLUGIN_EXPORT void PLUGIN_CALL Unload();
+PLUGIN_EXPORT void PLUGIN_CALL AmxLoad(AMX *amx);
+PLUGIN_EXPORT void PLUGIN_CALL AmxUnload(AMX *amx);
+PLUGIN_EXPORT void PLUGIN_CALL ProcessTick();
+
+namespace {
+
+std::unordered_map<AMX *, FakeAmx *> &GetInstances() {
+  static std::unordered_map<AMX *, FakeAmx *> instances;
+
+  return instances;
+}
+
+void LogPrintf(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+
+  std::vprintf(format, args);
+  std::printf("\n");
+
+  va_end(args);
+}
+
+void Unsupported() {
+  std::fprintf(stderr, "FakeAmx: unsupported AMX function called\n");
+
+  std::abort();
+}
+
+}  // namespace
+
+// Implementations of the AMX functions the server hands to plugins
+struct FakeAmxExports {
+  static int AMXAPI GetAddr(AMX *amx, cell amx_addr, cell **phys_addr) {
+    auto &fake = FakeAmx::FromAmx(amx);
+    if (amx_addr <= 0 ||
+        static_cast<std::size_t>(amx_addr) >= fake.memory_.size()) {
+      return AMX_ERR_MEMACCESS;
+    }
+
+    *phys_addr = &fake.memory_[amx_addr];
+
+    return AMX_ERR_NONE;
+  }
+
+  static int AMXAPI Allot(AMX *amx, int cells, cell *amx_addr,
+                          cell **phys_addr) {
+    auto &fake = FakeAmx::FromAmx(amx);
+
+    *amx_addr = fake.Allot(cells);
+
+    if (phys_addr) {
+      *phys_addr = &fake.memory_[*amx_addr];
+    }
+
+    return AMX_ERR_NONE;
+  }
+
+  static int AMXAPI Release(AMX *amx, cell amx_addr) {
+    FakeAmx::FromAmx(amx).Release(amx_addr);
+
+    return AMX_ERR_NONE;
+  }
+
+  static int AMXAPI Register(AMX *amx, const AMX_NATIVE_INFO *list,
+                             int number) {
+    auto &fake = FakeAmx::FromAmx(amx);
+
+    for (int i{}; (number < 0 || i < number) && list[i].name; ++i) {
+      fake.natives_[list[i].name] = list[i].func;
+    }
+
+    return AMX_ERR_NONE;
+  }
+
+  static int AMXAPI FindNative(AMX *amx, const char *name, int *index) {
+    auto &fake = FakeAmx::FromAmx(amx);
+
+    *index = fake.natives_.count(name) ? 0 : -1;
+
+    return *index < 0 ? AMX_ERR_NOTFOUND : AMX_ERR_NONE;
+  }
+
+  static int AMXAPI FindPublic(AMX *amx, const char *name, int *index) {
+    const auto &publics = FakeAmx::FromAmx(amx).publics_;
+
+    for (std::size_t i{}; i < publics.size(); ++i) {
+      if (publics[i].first == name) {
+        *index = static_cast<int>(i);
+
+        return AMX_ERR_NONE;
+      }
+    }
+
+    return AMX_ERR_NOTFOUND;
+  }
+
+  static int AMXAPI NumPublics(AMX *amx, int *number) {
+    *number = static_cast<int>(FakeAmx::FromAmx(amx).publics_.size());
+
+    return AMX_ERR_NONE;
+  }
+
+  static int AMXAPI GetPublic(AMX *amx, int index, char *name) {
+    const auto &publics = FakeAmx::FromAmx(amx).publics_;
+    if (index < 0 || static_cast<std::size_t>(index) >= publics.size()) {
+      return AMX_ERR_INDEX;
+    }
+
+    std::strcpy(name, publics[index].first.c_str());
+
+    return AMX_ERR_NONE;
+  }
+
+  static int AMXAPI FindPubVar(AMX *amx, const char *name, cell *amx_addr) {
+    auto &fake = FakeAmx::FromAmx(amx);
+    if (std::strcmp(name, "_pawnregex_version") != 0) {
+      return AMX_ERR_NOTFOUND;
+    }
+
+    *amx_addr = fake.version_addr_;
+
+    return AMX_ERR_NONE;
+  }
+
+  static int AMXAPI GetUserData(AMX *amx, long tag, void **ptr) {
+    auto &user_data = FakeAmx::FromAmx(amx).user_data_;
+
+    const auto iter = user_data.find(tag);
+    *ptr = iter == user_data.end() ? nullptr : iter->second;
+
+    return AMX_ERR_NONE;
+  }
+
+  static int AMXAPI SetUserData(AMX *amx, long tag, void *ptr) {
+    FakeAmx::FromAmx(amx).user_data_[tag] = ptr;
+
+    return AMX_ERR_NONE;
+  }
+
+  static int AMXAPI Push(AMX *amx, cell value) {
+    FakeAmx::FromAmx(amx).stack_.push_back(value);
+
+    return AMX_ERR_NONE;
+  }
+
+  static int AMXAPI PushArray(AMX *amx, cell *amx_addr, cell **phys_addr,
+                              const cell array[], int numcells) {
+    auto &fake = FakeAmx::FromAmx(amx);
+
+    const auto addr = fake.Allot(numcells);
+
+    std::copy(array, array + numcells, &fake.memory_[addr]);
+
+    if (amx_addr) {
+      *amx_addr = addr;
+    }
+
+    if (phys_addr) {
+      *phys_addr = &fake.memory_[addr];
+    }
+
+    fake.stack_.push_back(addr);
+
+    return AMX_ERR_NONE;
+  }
+
+  static int AMXAPI PushString(AMX *amx, cell *amx_addr, cell **phys_addr,
+                               const char *string, int /*pack*/,
+                               int /*use_wchar*/) {
+    auto &fake = FakeAmx::FromAmx(amx);
+
+    const auto addr = fake.String(string);
+
+    if (amx_addr) {
+      *amx_addr = addr;
+    }
+
+    if (phys_addr) {
+      *phys_addr = &fake.memory_[addr];
+    }
+
+    fake.stack_.push_back(addr);
+
+    return AMX_ERR_NONE;
+  }
+
+  static int AMXAPI Exec(AMX *amx, cell *retval, int index) {
+    auto &fake = FakeAmx::FromAmx(amx);
+    if (index < 0 || static_cast<std::size_t>(index) >= fake.publics_.size()) {
+      return AMX_ERR_INDEX;
+    }
+
+    // The first argument is pushed last
+    const std::vector<cell> args(fake.stack_.rbegin(), fake.stack_.rend());
+
+    fake.stack_.clear();
+
+    const auto result = fake.publics_[index].second(args);
+    if (retval) {
+      *retval = result;
+    }
+
+    return AMX_ERR_NONE;
+  }
+
+  static int AMXAPI RaiseError(AMX *amx, int error) {
+    amx->error = error;
+
+    return AMX_ERR_NONE;
+  }
+
+  static int AMXAPI StrLen(const cell *cstring, int *length) {
+    int len{};
+
+    if (static_cast<ucell>(*cstring) > UNPACKEDMAX) {
+      while (static_cast<ucell>(cstring[len / sizeof(cell)]) >>
+                 ((sizeof(cell) - 1 - len % sizeof(cell)) * 8) &
+             0xff) {
+        ++len;
+      }
+    } else {
+      while (cstring[len]) {
+        ++len;
+      }
+    }
+
+    *length = len;
+
+    return AMX_ERR_NONE;
+  }
+
+  static int AMXAPI GetString(char *dest, const cell *source,
+                              int /*use_wchar*/, size_t size) {
+    int length{};
+    StrLen(source, &length);
+
+    const bool packed = static_cast<ucell>(*source) > UNPACKEDMAX;
+
+    std::size_t i{};
+    for (; i < static_cast<std::size_t>(length) && i + 1 < size; ++i) {
+      dest[i] = packed ? static_cast<char>(
+                             static_cast<ucell>(source[i / sizeof(cell)]) >>
+                             ((sizeof(cell) - 1 - i % sizeof(cell)) * 8))
+                       : static_cast<char>(source[i]);
+    }
+
+    if (size) {
+      dest[i] = '\0';
+    }
+
+    return AMX_ERR_NONE;
+  }
+
+  static int AMXAPI SetString(cell *dest, const char *source, int pack,
+                              int /*use_wchar*/, size_t size) {
+    std::size_t i{};
+
+    if (pack) {
+      const auto max_chars = size * sizeof(cell) - 1;
+
+      std::fill(dest, dest + size, 0);
+
+      for (; source[i] && i < max_chars; ++i) {
+        dest[i / sizeof(cell)] |=
+            static_cast<cell>(static_cast<unsigned char>(source[i]))
+            << ((sizeof(cell) - 1 - i % sizeof(cell)) * 8);
+      }
+    } else {
+      for (; source[i] && i + 1 < size; ++i) {
+        dest[i] = static_cast<unsigned char>(source[i]);
+      }
+
+      if (size) {
+        dest[i] = 0;
+      }
+    }
+
+    return AMX_ERR_NONE;
+  }
+};
+
+FakeAmx::FakeAmx() : memory_(kMemorySize) {
+  Load();
+
+  GetInstances()[&amx_] = this;
+
+  heap_ = 1;
+
+  version_addr_ = Ref(PAWNREGEX_VERSION);
+
+  ::AmxLoad(&amx_);
+}
+
+FakeAmx::~FakeAmx() {
+  ::AmxUnload(&amx_);
+
+  GetInstances().erase(&amx_);
+}
+
+void FakeAmx::Load() {
+  static std::array<void *, PLUGIN_AMX_EXPORT_UTF8Put + 1> exports;
+  static std::array<void *, 256> plugin_data;
+
+  static bool loaded{};
+  if (loaded) {
+    return;
+  }
+
+  std::filesystem::create_directories("plugins");
+
+  exports.fill(reinterpret_cast<void *>(&Unsupported));
+
+  exports[PLUGIN_AMX_EXPORT_Allot] =
+      reinterpret_cast<void *>(&FakeAmxExports::Allot);
+  exports[PLUGIN_AMX_EXPORT_Exec] =
+      reinterpret_cast<void *>(&FakeAmxExports::Exec);
+  exports[PLUGIN_AMX_EXPORT_FindNative] =
+      reinterpret_cast<void *>(&FakeAmxExports::FindNative);
+  exports[PLUGIN_AMX_EXPORT_FindPublic] =
+      reinterpret_cast<void *>(&FakeAmxExports::FindPublic);
+  exports[PLUGIN_AMX_EXPORT_FindPubVar] =
+      reinterpret_cast<void *>(&FakeAmxExports::FindPubVar);
+  exports[PLUGIN_AMX_EXPORT_GetAddr] =
+      reinterpret_cast<void *>(&FakeAmxExports::GetAddr);
+  exports[PLUGIN_AMX_EXPORT_GetPublic] =
+      reinterpret_cast<void *>(&FakeAmxExports::GetPublic);
+  exports[PLUGIN_AMX_EXPORT_GetString] =
+      reinterpret_cast<void *>(&FakeAmxExports::GetString);
+  exports[PLUGIN_AMX_EXPORT_GetUserData] =
+      reinterpret_cast<void *>(&FakeAmxExports::GetUserData);
+  exports[PLUGIN_AMX_EXPORT_NumPublics] =
+      reinterpret_cast<void *>(&FakeAmxExports::NumPublics);
+  exports[PLUGIN_AMX_EXPORT_Push] =
+      reinterpret_cast<void *>(&FakeAmxExports::Push);
+  exports[PLUGIN_AMX_EXPORT_PushArray] =
+      reinterpret_cast<void *>(&FakeAmxExports::PushArray);
+  exports[PLUGIN_AMX_EXPORT_PushString] =
+      reinterpret_cast<void *>(&FakeAmxExports::PushString);
+  exports[PLUGIN_AMX_EXPORT_RaiseError] =
+      reinterpret_cast<void *>(&FakeAmxExports::RaiseError);
+  exports[PLUGIN_AMX_EXPORT_Register] =
+      reinterpret_cast<void *>(&FakeAmxExports::Register);
+  exports[PLUGIN_AMX_EXPORT_Release] =
+      reinterpret_cast<void *>(&FakeAmxExports::Release);
+  exports[PLUGIN_AMX_EXPORT_SetString] =
+      reinterpret_cast<void *>(&FakeAmxExports::SetString);
+  exports[PLUGIN_AMX_EXPORT_SetUserData] =
+      reinterpret_cast<void *>(&FakeAmxExports::SetUserData);
+  exports[PLUGIN_AMX_EXPORT_StrLen] =
+      reinterpret_cast<void *>(&FakeAmxExports::StrLen);
+
+  plugin_data[PLUGIN_DATA_LOGPRINTF] = reinterpret_cast<void *>(&LogPrintf);
+  plugin_data[PLUGIN_DATA_AMX_EXPORTS] = exports.data();
+
+  if (!::Load(plugin_data.data())) {
+    throw std::runtime_error{"Plugin failed to load"};
+  }
+
+  loaded = true;
+}
+
+void FakeAmx::Unload() { ::Unload(); }
+
+void FakeAmx::Tick() { ::ProcessTick(); }
+
+cell FakeAmx::String(std::string_view str) {
+  const auto addr = Allot(str.size() + 1);
+
+  for (std::size_t i{}; i < str.size(); ++i) {
+    memory_[addr + i] = static_cast<unsigned char>(str[i]);
+  }
+
+  memory_[addr + str.size()] = 0;
+
+  return addr;
+}
+
+cell FakeAmx::Ref(cell value) {
+  const auto addr = Allot(1);
+
+  memory_[addr] = value;
+
+  return addr;
+}
+
+cell FakeAmx::Array(std::size_t size) {
+  const auto addr = Allot(size);
+
+  std::fill_n(&memory_[addr], size, 0);
+
+  return addr;
+}
+
+cell FakeAmx::Array2D(std::size_t rows, std::size_t size) {
+  const auto addr = Allot(rows);
+
+  for (std::size_t row{}; row < rows; ++row) {
+    const auto row_addr = Array(size);
+
+    memory_[addr + row] = (row_addr - (addr + row)) * sizeof(cell);
+  }
+
+  return addr;
+}
+
+cell FakeAmx::StringArray(const std::vector<std::string> &strs) {
+  const auto addr = Allot(strs.size());
+
+  for (std::size_t row{}; row < strs.size(); ++row) {
+    const auto row_addr = String(strs[row]);
+
+    memory_[addr + row] = (row_addr - (addr + row)) * sizeof(cell);
+  }
+
+  return addr;
+}
+
+cell FakeAmx::Row(cell array, std::size_t row) const {
+  return array + row + memory_.at(array + row) / sizeof(cell);
+}
+
+std::string FakeAmx::GetString(cell addr) const {
+  std::string str;
+
+  for (auto i = static_cast<std::size_t>(addr); memory_.at(i); ++i) {
+    str.push_back(static_cast<char>(memory_[i]));
+  }
+
+  return str;
+}
+
+void FakeAmx::AddPublic(const std::string &name, Public func) {
+  publics_.emplace_back(name, std::move(func));
+}
+
+FakeAmx &FakeAmx::FromAmx(AMX *amx) { return *GetInstances().at(amx); }
+
+cell FakeAmx::CallNative(const char *name, const cell *params) {
+  const auto iter = natives_.find(name);
+  if (iter == natives_.end()) {
+    throw std::runtime_error{std::string{"Native "} + name + " not found"};
+  }
+
+  return iter->second(&amx_, params);
+}
+
+cell FakeAmx::Allot(std::size_t cells) {
+  if (heap_ + cells > memory_.size()) {
+    throw std::runtime_error{"FakeAmx is out of memory"};
+  }
+
+  const auto addr = heap_;
+
+  heap_ += static_cast<cell>(cells);
+
+  return addr;
+}
@@ -0,0 +1,107 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PAWNREGEX_TEST_FAKE_AMX_H_
+#define PAWNREGEX_TEST_FAKE_AMX_H_
+
+#include "main.h"
+
+// In-process stand-in for the server. The plugin is loaded through its
+// exported entry points with a table of fake AMX functions, so natives run
+// through the same ptl wrappers as on a real server. Script memory is a flat
+// array of cells addressed by index.
+class FakeAmx {
+ public:
+  using Public = std::function<cell(const std::vector<cell> &args)>;
+
+  FakeAmx();
+
+  // Unloads the script like the server does when it exits
+  ~FakeAmx();
+
+  // Loads the plugin on first use, see Unload
+  static void Load();
+
+  static void Unload();
+
+  // Runs Plugin::OnProcessTick, which delivers async completions
+  static void Tick();
+
+  cell String(std::string_view str);
+
+  cell Ref(cell value = 0);
+
+  cell Array(std::size_t size);
+
+  // 2D arrays are laid out like the compiler does it: a table of byte offsets
+  // from each table cell to its row, followed by the rows
+  cell Array2D(std::size_t rows, std::size_t size);
+
+  cell StringArray(const std::vector<std::string> &strs);
+
+  cell Row(cell array, std::size_t row) const;
+
+  cell &At(cell addr) { return memory_.at(addr); }
+
+  std::string GetString(cell addr) const;
+
+  // Releases everything allocated since mark, see GetHeapMark
+  void Release(cell mark) { heap_ = std::min(heap_, mark); }
+
+  cell GetHeapMark() const { return heap_; }
+
+  void AddPublic(const std::string &name, Public func);
+
+  template <typename... Args>
+  cell Call(const char *name, Args... args) {
+    const cell params[] = {static_cast<cell>(sizeof...(args) * sizeof(cell)),
+                           static_cast<cell>(args)...};
+
+    return CallNative(name, params);
+  }
+
+  AMX *GetAmx() { return &amx_; }
+
+ private:
+  static constexpr std::size_t kMemorySize = 1 << 22;
+
+  friend struct FakeAmxExports;
+
+  static FakeAmx &FromAmx(AMX *amx);
+
+  cell CallNative(const char *name, const cell *params);
+
+  cell Allot(std::size_t cells);
+
+  AMX amx_{};
+  std::vector<cell> memory_;
+  cell heap_{};
+  cell version_addr_{};
+  std::unordered_map<std::string, AMX_NATIVE> natives_;
+  std::vector<std::pair<std::string, Public>> publics_;
+  std::vector<cell> stack_;
+  std::unordered_map<long, void *> user_data_;
+};
+
+#endif  // PAWNREGEX_TEST_FAKE_AMX_H_
@@ -0,0 +1,1245 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2021 katursis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "fake_amx.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<std::size_t> allocations{};
+
+void *Allocate(std::size_t size) {
+  ++allocations;
+
+  if (const auto ptr = std::malloc(size ? size : 1)) {
+    return ptr;
+  }
+
+  throw std::bad_alloc{};
+}
+
+}  // namespace
+
+// Counts every allocation of the process, see TestAllocations. All forms of
+// new go through malloc and all forms of delete through free, over-aligned
+// ones included, so each delete matches the new it is paired with
+void *operator new(std::size_t size) { return Allocate(size); }
+
+void *operator new[](std::size_t size) { return Allocate(size); }
+
+void *operator new(std::size_t size, std::align_val_t align) {
+  const auto alignment = static_cast<std::size_t>(align);
+  const auto raw =
+      static_cast<char *>(Allocate(size + alignment + sizeof(void *)));
+  const auto offset =
+      reinterpret_cast<std::uintptr_t>(raw + sizeof(void *)) % alignment;
+  const auto ptr = raw + sizeof(void *) + (offset ? alignment - offset : 0);
+
+  reinterpret_cast<void **>(ptr)[-1] = raw;
+
+  return ptr;
+}
+
+void *operator new[](std::size_t size, std::align_val_t align) {
+  return operator new(size, align);
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, std::align_val_t) noexcept {
+  if (ptr) {
+    std::free(static_cast<void **>(ptr)[-1]);
+  }
+}
+
+void operator delete[](void *ptr, std::align_val_t align) noexcept {
+  operator delete(ptr, align);
+}
+
+void operator delete(void *ptr, std::size_t,
+                     std::align_val_t align) noexcept {
+  operator delete(ptr, align);
+}
+
+void operator delete[](void *ptr, std::size_t,
+                       std::align_val_t align) noexcept {
+  operator delete(ptr, align);
+}
+
+namespace {
+
+int failures{};
+
+void Expect(bool ok, const char *expr, int line) {
+  if (!ok) {
+    std::printf("  line %d: expected %s\n", line, expr);
+
+    ++failures;
+  }
+}
+
+#define EXPECT(expr) Expect((expr), #expr, __LINE__)
+
+void TestCheck(FakeAmx &amx) {
+  const auto regex =
+      amx.Call("Regex_New", amx.String("[A-Z][a-z]+_[A-Z][a-z]+"),
+               REGEX_DEFAULT, REGEX_ECMASCRIPT);
+  EXPECT(regex != 0);
+
+  EXPECT(amx.Call("Regex_Check", amx.String("Firstname_Lastname"), regex,
+                  MATCH_DEFAULT) == 1);
+  EXPECT(amx.Call("Regex_Check", amx.String("katursis"), regex,
+                  MATCH_DEFAULT) == 0);
+
+  const auto ref = amx.Ref(regex);
+  EXPECT(amx.Call("Regex_Delete", ref) == 1);
+  EXPECT(amx.At(ref) == 0);
+
+  // A deleted handle is rejected
+  EXPECT(amx.Call("Regex_Check", amx.String("Firstname_Lastname"), regex,
+                  MATCH_DEFAULT) == 0);
+
+  // and is not handed out again soon
+  const auto pattern = amx.String("[a-z]+");
+  const auto churn_ref = amx.Ref();
+  bool reused{};
+  for (int i{}; i < 5000; ++i) {
+    amx.At(churn_ref) =
+        amx.Call("Regex_New", pattern, REGEX_DEFAULT, REGEX_ECMASCRIPT);
+    reused |= amx.At(churn_ref) == regex;
+    amx.Call("Regex_Delete", churn_ref);
+  }
+  EXPECT(!reused);
+}
+
+void TestMatchGroups(FakeAmx &amx) {
+  const auto regex =
+      amx.Call("Regex_New", amx.String("^\\/(\\w+)\\s*(.+?)?\\s*$"),
+               REGEX_DEFAULT, REGEX_ECMASCRIPT);
+
+  const auto match = amx.Ref();
+  EXPECT(amx.Call("Regex_Match", amx.String("/ban 42"), regex, match,
+                  MATCH_DEFAULT) == 1);
+  EXPECT(amx.Call("Match_GetGroupCount", amx.At(match)) == 3);
+
+  const auto dest = amx.Array(32);
+  const auto length = amx.Ref();
+  EXPECT(amx.Call("Match_GetGroup", amx.At(match), 1, dest, length, 32) == 1);
+  EXPECT(amx.GetString(dest) == "ban");
+  EXPECT(amx.At(length) == 3);
+
+  const auto start = amx.Ref();
+  EXPECT(amx.Call("Match_GetGroupPos", amx.At(match), 2, start, length) == 1);
+  EXPECT(amx.At(start) == 5);
+  EXPECT(amx.At(length) == 2);
+
+  EXPECT(amx.Call("Match_Free", match) == 1);
+  EXPECT(amx.At(match) == 0);
+
+  EXPECT(amx.Call("Regex_Match", amx.String("ban 42"), regex, match,
+                  MATCH_DEFAULT) == 0);
+}
+
+void TestNamedGroups(FakeAmx &amx) {
+  const auto regex = amx.Call(
+      "Regex_New", amx.String("^/(?<cmd>\\w+)[(]?\\s*(?<arg>.*)$"),
+      REGEX_DEFAULT, REGEX_ECMASCRIPT);
+
+  EXPECT(amx.Call("Regex_GetGroupIndex", regex, amx.String("cmd")) == 1);
+  EXPECT(amx.Call("Regex_GetGroupIndex", regex, amx.String("arg")) == 2);
+  EXPECT(amx.Call("Regex_GetGroupIndex", regex, amx.String("x")) == -1);
+
+  const auto match = amx.Ref();
+  const auto dest = amx.Array(32);
+  const auto length = amx.Ref();
+
+  EXPECT(amx.Call("Regex_Match", amx.String("/ban 42"), regex, match,
+                  MATCH_DEFAULT) == 1);
+  EXPECT(amx.Call("Match_GetNamedGroup", amx.At(match), amx.String("arg"),
+                  dest, length, 32) == 1);
+  EXPECT(amx.GetString(dest) == "42");
+  EXPECT(amx.Call("Match_GetNamedGroup", amx.At(match), amx.String("x"),
+                  dest, length, 32) == 0);
+  amx.Call("Match_Free", match);
+
+  const auto repeated = amx.Call(
+      "Regex_New", amx.String("(?<ch>[a-z])\\k<ch>1"), REGEX_DEFAULT,
+      REGEX_ECMASCRIPT);
+  EXPECT(amx.Call("Regex_Check", amx.String("aa1"), repeated,
+                  MATCH_DEFAULT) == 1);
+  EXPECT(amx.Call("Regex_Check", amx.String("ab1"), repeated,
+                  MATCH_DEFAULT) == 0);
+}
+
+void TestSearch(FakeAmx &amx) {
+  const auto regex = amx.Call("Regex_New", amx.String("\\d+"), REGEX_DEFAULT,
+                              REGEX_ECMASCRIPT);
+
+  const auto str = amx.String("a1 b22 c333");
+  const auto match = amx.Ref();
+  const auto pos = amx.Ref();
+
+  EXPECT(amx.Call("Regex_Search", str, regex, match, pos, 2, MATCH_DEFAULT) ==
+         1);
+  EXPECT(amx.At(pos) == 4);
+  amx.Call("Match_Free", match);
+
+  EXPECT(amx.Call("Regex_Search", str, regex, match, pos, 2,
+                  MATCH_DEFAULT | MATCH_RELATIVE_POS) == 1);
+  EXPECT(amx.At(pos) == 2);
+  amx.Call("Match_Free", match);
+
+  EXPECT(amx.Call("Regex_Search", str, regex, match, pos, 100,
+                  MATCH_DEFAULT) == 0);
+}
+
+void TestReplace(FakeAmx &amx) {
+  const auto regex = amx.Call("Regex_New", amx.String("(.+)\\.(.+)"),
+                              REGEX_DEFAULT, REGEX_ECMASCRIPT);
+
+  const auto dest = amx.Array(64);
+  EXPECT(amx.Call("Regex_Replace", amx.String("Regex.Pawn"), regex,
+                  amx.String("$2.$1"), dest, MATCH_DEFAULT, 64) == 1);
+  EXPECT(amx.GetString(dest) == "Pawn.Regex");
+
+  // A result cut to fit dest is reported
+  EXPECT(amx.Call("Regex_Replace", amx.String("Regex.Pawn"), regex,
+                  amx.String("$2.$1"), dest, MATCH_DEFAULT, 5) == 0);
+  EXPECT(amx.GetString(dest) == "Pawn");
+  EXPECT(amx.Call("Regex_GetLastError") == REGEX_ERROR_TRUNCATED);
+
+  EXPECT(amx.Call("Regex_ReplaceP", amx.String("a-b-c"), amx.String("-"),
+                  amx.String("+"), dest, MATCH_DEFAULT, REGEX_DEFAULT,
+                  REGEX_ECMASCRIPT, 64) == 1);
+  EXPECT(amx.GetString(dest) == "a+b+c");
+
+  const auto dashes = amx.Call("Regex_New", amx.String("-"), REGEX_DEFAULT,
+                               REGEX_ECMASCRIPT);
+  const auto needed = amx.Ref();
+  const auto replacements = amx.Ref();
+
+  EXPECT(amx.Call("Regex_ReplaceEx", amx.String("a-b-c"), dashes,
+                  amx.String("<->"), dest, needed, replacements,
+                  MATCH_DEFAULT, 64) == 1);
+  EXPECT(amx.GetString(dest) == "a<->b<->c");
+  EXPECT(amx.At(needed) == 9);
+  EXPECT(amx.At(replacements) == 2);
+
+  EXPECT(amx.Call("Regex_ReplaceEx", amx.String("a-b-c"), dashes,
+                  amx.String("<->"), dest, needed, replacements,
+                  MATCH_FORMAT_FIRST_ONLY, 5) == 0);
+  EXPECT(amx.GetString(dest) == "a<->");
+  EXPECT(amx.Call("Regex_GetLastError") == REGEX_ERROR_TRUNCATED);
+  EXPECT(amx.At(needed) == 7);
+  EXPECT(amx.At(replacements) == 1);
+}
+
+void TestAllocations(FakeAmx &amx) {
+  // Allocations made by 100 calls, after the thread-local string buffers have
+  // grown on the first ones
+  const auto count = [&amx](const char *name, auto... args) {
+    for (int i{}; i < 10; ++i) {
+      amx.Call(name, args...);
+    }
+
+    const auto before = allocations.load();
+
+    for (int i{}; i < 100; ++i) {
+      amx.Call(name, args...);
+    }
+
+    return allocations.load() - before;
+  };
+
+  const auto literal = amx.Call("Regex_New", amx.String("idiot"),
+                                REGEX_DEFAULT, REGEX_ECMASCRIPT);
+  const auto nickname =
+      amx.Call("Regex_New", amx.String("[A-Z][a-z]+_[A-Z][a-z]+"),
+               REGEX_DEFAULT, REGEX_ECMASCRIPT);
+
+  const auto name = amx.String("Firstname_Lastname");
+  const auto insult = amx.String("idiot");
+  const auto dest = amx.Array(32);
+  const auto fmt = amx.String("-");
+
+  // std::regex allocates its own state when it runs, the natives add nothing
+  // on top of it
+  const std::regex engine{"[A-Z][a-z]+_[A-Z][a-z]+"};
+  const std::string subject{"Firstname_Lastname"};
+
+  const auto before = allocations.load();
+
+  for (int i{}; i < 100; ++i) {
+    std::regex_match(subject, engine);
+  }
+
+  const auto engine_count = allocations.load() - before;
+
+  EXPECT(count("Regex_Check", name, nickname, MATCH_DEFAULT) <= engine_count);
+
+  // and nothing at all for subjects the literal checks settle
+  EXPECT(count("Regex_Check", name, literal, MATCH_DEFAULT) == 0);
+  EXPECT(count("Regex_Check", insult, literal, MATCH_DEFAULT) == 0);
+  EXPECT(count("Regex_Check", insult, nickname, MATCH_DEFAULT) == 0);
+  EXPECT(count("Regex_Replace", name, literal, fmt, dest, MATCH_DEFAULT,
+                32) == 0);
+  EXPECT(count("Regex_Replace", insult, nickname, fmt, dest, MATCH_DEFAULT,
+                32) == 0);
+
+  amx.Call("Regex_Delete", amx.Ref(nickname));
+  amx.Call("Regex_Delete", amx.Ref(literal));
+}
+
+void TestCharModes(FakeAmx &amx) {
+  // "Привет, мир" in UTF-8
+  const std::string hello =
+      "\xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82, "
+      "\xD0\xBC\xD0\xB8\xD1\x80";
+
+  const auto utf8 = amx.Call("Regex_New", amx.String("^\\w+"), REGEX_UTF8,
+                             REGEX_ECMASCRIPT);
+  const auto bytes = amx.Call("Regex_New", amx.String("^\\w+"), REGEX_BYTES,
+                              REGEX_ECMASCRIPT);
+
+  const auto str = amx.String(hello);
+  const auto match = amx.Ref();
+  const auto pos = amx.Ref();
+  const auto start = amx.Ref();
+  const auto length = amx.Ref();
+
+  // Cyrillic letters are word characters, positions stay in bytes
+  EXPECT(amx.Call("Regex_Search", str, utf8, match, pos, 0, MATCH_DEFAULT) ==
+         1);
+  amx.Call("Match_GetGroupPos", amx.At(match), 0, start, length);
+  EXPECT(amx.At(length) == 12);
+  amx.Call("Match_Free", match);
+
+  EXPECT(amx.Call("Regex_Search", str, bytes, match, pos, 0, MATCH_DEFAULT) ==
+         0);
+
+  // The character before startpos takes two bytes and is a word character
+  const auto word = amx.Call("Regex_New", amx.String("\\b\\w"), REGEX_UTF8,
+                             REGEX_ECMASCRIPT);
+  EXPECT(amx.Call("Regex_Search", str, word, match, pos, 2, MATCH_DEFAULT) ==
+         1);
+  EXPECT(amx.At(pos) == 14);
+  amx.Call("Match_Free", match);
+
+  // Case folding and quantifiers apply to whole characters
+  const auto icase = amx.Call(
+      "Regex_New", amx.String("\xD0\xBC\xD0\xB8\xD1\x80\xD1\x8B?$"),
+      REGEX_UTF8 | REGEX_ICASE, REGEX_ECMASCRIPT);
+  EXPECT(amx.Call("Regex_Check", amx.String("\xD0\x9C\xD0\x98\xD0\xA0"),
+                  icase, MATCH_DEFAULT) == 1);
+
+  const auto dest = amx.Array(64);
+  EXPECT(amx.Call("Regex_ReplaceP", str, amx.String("(\\w+)"),
+                  amx.String("<$1>"), dest, MATCH_DEFAULT, REGEX_UTF8,
+                  REGEX_ECMASCRIPT, 64) == 1);
+  EXPECT(amx.GetString(dest) == "<" + hello.substr(0, 12) + ">, <" +
+                                    hello.substr(14) + ">");
+
+  // Case-insensitive ranges of non-ASCII letters
+  EXPECT(amx.Call("Regex_CheckP", amx.String("\xD0\x9F\xD0\xA0\xD0\x98"),
+                  amx.String("[\xD0\xB0-\xD1\x8F]+"), MATCH_DEFAULT,
+                  REGEX_UTF8 | REGEX_ICASE, REGEX_ECMASCRIPT) == 1);
+  EXPECT(amx.Call("Regex_CheckP", amx.String("\xC3\x89"),
+                  amx.String("[\xC3\xA0-\xC3\xBF]"), MATCH_DEFAULT,
+                  REGEX_UTF8 | REGEX_ICASE, REGEX_ECMASCRIPT) == 1);
+  EXPECT(amx.Call("Regex_CheckP", amx.String("\xC3\xA9"),
+                  amx.String("[\xC3\x80-\xC3\x9E]"), MATCH_DEFAULT,
+                  REGEX_UTF8 | REGEX_ICASE, REGEX_ECMASCRIPT) == 1);
+  EXPECT(amx.Call("Regex_CheckP", amx.String("\xC3\x89"),
+                  amx.String("[\xC3\xA0-\xC3\xBF]"), MATCH_DEFAULT,
+                  REGEX_UTF8, REGEX_ECMASCRIPT) == 0);
+
+  // Only ASCII letters have a case in byte mode
+  EXPECT(amx.Call("Regex_CheckP", amx.String("PAWN"), amx.String("pawn"),
+                  MATCH_DEFAULT, REGEX_BYTES | REGEX_ICASE,
+                  REGEX_ECMASCRIPT) == 1);
+
+  // Collating element names come from the locale
+  EXPECT(amx.Call("Regex_CheckP", amx.String("a-b"),
+                  amx.String("a[[.hyphen.]]b"), MATCH_DEFAULT,
+                  REGEX_LOCALE, REGEX_ECMASCRIPT) == 1);
+  EXPECT(amx.Call("Regex_CheckP", amx.String("a-b"),
+                  amx.String("a[[.-.]]b"), MATCH_DEFAULT, REGEX_BYTES,
+                  REGEX_ECMASCRIPT) == 1);
+  EXPECT(amx.Call("Regex_CheckP", amx.String("a-b"),
+                  amx.String("a[[.hyphen.]]b"), MATCH_DEFAULT, REGEX_BYTES,
+                  REGEX_ECMASCRIPT) == 0);
+}
+
+void TestEngines(FakeAmx &amx) {
+  // Everything the natives report about a subject: Regex_Check, the groups of
+  // Regex_Search, Regex_Replace and the spans of Regex_SearchAllPos
+  const auto describe = [&amx](cell regex, const std::string &subject) {
+    const auto str = amx.String(subject);
+
+    auto result =
+        std::to_string(amx.Call("Regex_Check", str, regex, MATCH_DEFAULT));
+
+    const auto match = amx.Ref();
+    const auto pos = amx.Ref();
+    const auto start = amx.Ref();
+    const auto length = amx.Ref();
+
+    if (amx.Call("Regex_Search", str, regex, match, pos, 0, MATCH_DEFAULT)) {
+      const auto groups = amx.Call("Match_GetGroupCount", amx.At(match));
+
+      for (cell i{}; i < groups; ++i) {
+        amx.Call("Match_GetGroupPos", amx.At(match), i, start, length);
+
+        result += " " + std::to_string(amx.At(start)) + "+" +
+                  std::to_string(amx.At(length));
+      }
+
+      amx.Call("Match_Free", match);
+    }
+
+    const auto dest = amx.Array(128);
+    amx.Call("Regex_Replace", str, regex, amx.String("[$&|$1]"), dest,
+             MATCH_DEFAULT, 128);
+
+    result += " " + amx.GetString(dest);
+
+    const auto spans = amx.Array(64);
+    const auto count = amx.Ref();
+    amx.Call("Regex_SearchAllPos", str, regex, spans, count, MATCH_DEFAULT,
+             64);
+
+    for (cell i{}; i < amx.At(count) * 2; ++i) {
+      result += " " + std::to_string(amx.At(spans + i));
+    }
+
+    return result;
+  };
+
+  // ECMAScript patterns both engines read the same way
+  const std::pair<const char *, const char *> cases[] = {
+      {"(\\w+)@(\\w+)\\.com", "mail john@example.com or jane@test.com"},
+      {"^(\\d{3})-(\\d{4})$", "555-1234"},
+      {"^(\\d{3})-(\\d{4})$", "555-12345"},
+      {"(a|ab)(c|bcd)(d*)", "abcd"},
+      {"(a+?)(b*)", "aaabbb"},
+      {"([A-Z][a-z]+)_([A-Z][a-z]+)", "Firstname_Lastname"},
+      {"(x)?y", "zy"},
+      {"\\bcat\\b", "concat cat cats"},
+      {"[^\\s,]+", "a, bb,ccc"},
+      {"(?:ab)+|c", "xababc"},
+      {"a*", "baaa"},
+      {"(\\d+)(?:px|em)?", "12px 3em 4"},
+      {"[[:alpha:]]+", "abc123def"},
+      {".", "\xD0\x9F\xD1\x80"},
+      {"(a+)+$", "aaaa!"},
+  };
+
+  for (const auto &[pattern, subject] : cases) {
+    for (const auto mode : {REGEX_BYTES, REGEX_UTF8}) {
+      const auto std_regex = amx.Call("Regex_New", amx.String(pattern),
+                                      mode | REGEX_STD, REGEX_ECMASCRIPT);
+      const auto re2_regex = amx.Call("Regex_New", amx.String(pattern),
+                                      mode | REGEX_RE2, REGEX_ECMASCRIPT);
+      EXPECT(std_regex != 0);
+      EXPECT(re2_regex != 0);
+
+      const auto expected = describe(std_regex, subject);
+      const auto actual = describe(re2_regex, subject);
+      if (expected != actual) {
+        std::printf("  %s: %s != %s\n", pattern, expected.c_str(),
+                    actual.c_str());
+      }
+
+      EXPECT(expected == actual);
+    }
+  }
+
+  // Case-insensitive patterns, only ASCII letters have a case in both
+  EXPECT(amx.Call("Regex_CheckP", amx.String("Pawn.REGEX"),
+                  amx.String("pawn\\.regex"), MATCH_DEFAULT,
+                  REGEX_ICASE | REGEX_RE2, REGEX_ECMASCRIPT) == 1);
+
+  // No backtracking, so no MatchStepLimit is needed either
+  const auto nested = amx.Call("Regex_New", amx.String("(a+)+$"), REGEX_RE2,
+                               REGEX_ECMASCRIPT);
+  EXPECT(amx.Call("Regex_Check", amx.String(std::string(4000, 'a') + "!"),
+                  nested, MATCH_DEFAULT) == 0);
+  EXPECT(amx.Call("Regex_GetLastError") == REGEX_ERROR_NONE);
+
+  // Characters before startpos count as with std::regex
+  const auto word = amx.Call("Regex_New", amx.String("\\bb"), REGEX_RE2,
+                             REGEX_ECMASCRIPT);
+  const auto match = amx.Ref();
+  const auto pos = amx.Ref();
+  EXPECT(amx.Call("Regex_Search", amx.String("ab b"), word, match, pos, 1,
+                  MATCH_DEFAULT) == 1);
+  EXPECT(amx.At(pos) == 3);
+  amx.Call("Match_Free", match);
+  EXPECT(amx.Call("Regex_Search", amx.String("ab b"), word, match, pos, 1,
+                  MATCH_RELATIVE_POS) == 1);
+  EXPECT(amx.At(pos) == 0);
+  amx.Call("Match_Free", match);
+
+  // What only std::regex supports
+  EXPECT(amx.Call("Regex_New", amx.String("(a)\\1"), REGEX_RE2,
+                  REGEX_ECMASCRIPT) == 0);
+  EXPECT(amx.Call("Regex_New", amx.String("a(?=b)"), REGEX_RE2,
+                  REGEX_ECMASCRIPT) == 0);
+  EXPECT(amx.Call("Regex_New", amx.String("a"), REGEX_RE2, REGEX_BASIC) == 0);
+  EXPECT(amx.Call("Regex_Check", amx.String("b"), word, MATCH_NOT_BOL) ==
+         0);
+  EXPECT(amx.Call("RegexStream_New", word, 16, MATCH_DEFAULT) == 0);
+}
+
+void TestBatch(FakeAmx &amx) {
+  const auto regex =
+      amx.Call("Regex_New", amx.String("[A-Z][a-z]+_[A-Z][a-z]+"),
+               REGEX_DEFAULT, REGEX_ECMASCRIPT);
+
+  // Enough rows to be split across the worker threads
+  std::vector<std::string> names;
+  for (int i{}; i < 2000; ++i) {
+    names.push_back(i % 3 ? "John_Smith" : "john");
+  }
+
+  const auto strings = amx.StringArray(names);
+  const auto results = amx.Array(names.size());
+
+  EXPECT(amx.Call("Regex_CheckMany", strings, names.size(), regex, results,
+                  MATCH_DEFAULT, names.size(), names.size()) == 1333);
+  EXPECT(amx.At(results) == 0);
+  EXPECT(amx.At(results + 1) == 1);
+  EXPECT(amx.At(results + 1999) == 1);
+
+  EXPECT(amx.Call("Regex_CheckMany", strings, names.size(), regex, results,
+                  MATCH_DEFAULT, 2, names.size()) == 1);
+
+  // count never reaches past the rows of strings[][]
+  const auto few = amx.StringArray({"John_Smith", "Jane_Doe"});
+  EXPECT(amx.Call("Regex_CheckMany", few, 100, regex, results, MATCH_DEFAULT,
+                  names.size(), 2) == 2);
+  EXPECT(amx.Call("Regex_CheckMany", few, 100, regex, results, MATCH_DEFAULT,
+                  names.size(), 100) == 0);
+
+  const auto digits = amx.Call("Regex_New", amx.String("\\d"), REGEX_DEFAULT,
+                               REGEX_ECMASCRIPT);
+
+  const auto dest = amx.Array2D(3, 16);
+  const auto strings_3 = amx.StringArray({"a1b2", "", "42"});
+  EXPECT(amx.Call("Regex_ReplaceMany", strings_3, 3, digits, amx.String("#"),
+                  dest, MATCH_DEFAULT, 16, 3, 3) == 3);
+  EXPECT(amx.GetString(amx.Row(dest, 0)) == "a#b#");
+  EXPECT(amx.GetString(amx.Row(dest, 1)).empty());
+  EXPECT(amx.GetString(amx.Row(dest, 2)) == "##");
+
+  const auto small_dest = amx.Array2D(2, 16);
+  EXPECT(amx.Call("Regex_ReplaceMany", strings_3, 3, digits, amx.String("#"),
+                  small_dest, MATCH_DEFAULT, 16, 3, 2) == 2);
+  EXPECT(amx.Call("Regex_ReplaceMany", strings_3, 3, digits, amx.String("#"),
+                  small_dest, MATCH_DEFAULT, 16, 3, 3) == 0);
+}
+
+void TestSearchAll(FakeAmx &amx) {
+  const auto regex = amx.Call("Regex_New", amx.String("[^\\s]+"),
+                              REGEX_DEFAULT, REGEX_ECMASCRIPT);
+
+  const auto str = amx.String("4 8 15 16 23 42");
+  const auto list = amx.Ref();
+  EXPECT(amx.Call("Regex_SearchAll", str, regex, list, MATCH_DEFAULT) == 6);
+
+  const auto dest = amx.Array(16);
+  const auto length = amx.Ref();
+  EXPECT(amx.Call("MatchList_GetGroup", amx.At(list), 2, 0, dest, length,
+                  16) == 1);
+  EXPECT(amx.GetString(dest) == "15");
+
+  EXPECT(amx.Call("MatchList_Free", list) == 1);
+
+  const auto spans = amx.Array(8);
+  const auto count = amx.Ref();
+  EXPECT(amx.Call("Regex_SearchAllPos", str, regex, spans, count,
+                  MATCH_DEFAULT, 8) == 4);
+  EXPECT(amx.At(spans + 4) == 4);
+  EXPECT(amx.At(spans + 5) == 2);
+}
+
+void TestLiteralPatterns(FakeAmx &amx) {
+  const auto match = amx.Ref();
+  const auto pos = amx.Ref();
+
+  const auto literal = amx.Call("Regex_New", amx.String("discord\\.gg"),
+                                REGEX_DEFAULT, REGEX_ECMASCRIPT);
+  EXPECT(amx.Call("Regex_Check", amx.String("discord.gg"), literal,
+                  MATCH_DEFAULT) == 1);
+  EXPECT(amx.Call("Regex_Check", amx.String("discordXgg"), literal,
+                  MATCH_DEFAULT) == 0);
+  EXPECT(amx.Call("Regex_Check", amx.String("discord.gg/x"), literal,
+                  MATCH_DEFAULT) == 0);
+  EXPECT(amx.Call("Regex_Search", amx.String("join discord.gg/abc"), literal,
+                  match, pos, 0, MATCH_DEFAULT) == 1);
+  EXPECT(amx.At(pos) == 5);
+  amx.Call("Match_Free", match);
+
+  const auto anchored = amx.Call("Regex_New", amx.String("^/help"),
+                                 REGEX_DEFAULT, REGEX_ECMASCRIPT);
+  const auto help = amx.String("/help me");
+  EXPECT(amx.Call("Regex_Search", help, anchored, match, pos, 0,
+                  MATCH_DEFAULT) == 1);
+  EXPECT(amx.At(pos) == 0);
+  amx.Call("Match_Free", match);
+  EXPECT(amx.Call("Regex_Search", help, anchored, match, pos, 1,
+                  MATCH_DEFAULT) == 0);
+  EXPECT(amx.Call("Regex_Search", amx.String("x/help"), anchored, match, pos,
+                  0, MATCH_DEFAULT) == 0);
+
+  // A top-level alternative is not anchored
+  const auto either = amx.Call("Regex_New", amx.String("^a|b"), REGEX_DEFAULT,
+                               REGEX_ECMASCRIPT);
+  EXPECT(amx.Call("Regex_Search", amx.String("xb"), either, match, pos, 0,
+                  MATCH_DEFAULT) == 1);
+  EXPECT(amx.At(pos) == 1);
+  amx.Call("Match_Free", match);
+
+  const auto dest = amx.Array(32);
+  EXPECT(amx.Call("Regex_Replace", amx.String("xb"), either, amx.String("-"),
+                  dest, MATCH_DEFAULT, 32) == 1);
+  EXPECT(amx.GetString(dest) == "x-");
+
+  const auto icase = amx.Call("Regex_New", amx.String("needle\\d"),
+                              REGEX_ICASE, REGEX_ECMASCRIPT);
+  const auto haystack = amx.String(std::string(150, 'n') + "NeEdLe NEEDLE7" +
+                                   std::string(50, 'e'));
+  EXPECT(amx.Call("Regex_Search", haystack, icase, match, pos, 0,
+                  MATCH_DEFAULT) == 1);
+  EXPECT(amx.At(pos) == 157);
+  amx.Call("Match_Free", match);
+
+  const auto prefixed = amx.Call("Regex_New", amx.String("ab+"), REGEX_DEFAULT,
+                                 REGEX_ECMASCRIPT);
+  const auto spans = amx.Array(8);
+  const auto count = amx.Ref();
+  EXPECT(amx.Call("Regex_SearchAllPos", amx.String("ab abb xab"), prefixed,
+                  spans, count, MATCH_DEFAULT, 8) == 3);
+  EXPECT(amx.At(spans + 2) == 3);
+  EXPECT(amx.At(spans + 3) == 3);
+  EXPECT(amx.At(spans + 4) == 8);
+
+  EXPECT(amx.Call("Regex_Replace", amx.String("no match here"), prefixed,
+                  amx.String("-"), dest, MATCH_DEFAULT, 32) == 1);
+  EXPECT(amx.GetString(dest) == "no match here");
+}
+
+void TestRegexSet(FakeAmx &amx) {
+  const auto set = amx.Call("RegexSet_New");
+
+  EXPECT(amx.Call("RegexSet_Add", set, amx.String("idiot"), REGEX_ICASE,
+                  REGEX_ECMASCRIPT) == 0);
+  EXPECT(amx.Call("RegexSet_Add", set, amx.String("\\d{3}-\\d{4}"),
+                  REGEX_DEFAULT, REGEX_ECMASCRIPT) == 1);
+  EXPECT(amx.Call("RegexSet_Add", set, amx.String("^!"), REGEX_DEFAULT,
+                  REGEX_ECMASCRIPT) == 2);
+  EXPECT(amx.Call("RegexSet_Add", set, amx.String("(unclosed"),
+                  REGEX_DEFAULT, REGEX_ECMASCRIPT) == -1);
+  EXPECT(amx.Call("RegexSet_Add", 0, amx.String("idiot"), REGEX_DEFAULT,
+                  REGEX_ECMASCRIPT) == -1);
+  EXPECT(amx.Call("RegexSet_Compile", set) == 1);
+
+  const auto ids = amx.Array(4);
+  const auto count = amx.Ref();
+  EXPECT(amx.Call("RegexSet_Match", amx.String("call 555-1234, IDIOT"), set,
+                  ids, count, MATCH_DEFAULT, 4) == 1);
+  EXPECT(amx.At(count) == 2);
+  EXPECT(amx.At(ids) == 0);
+  EXPECT(amx.At(ids + 1) == 1);
+
+  EXPECT(amx.Call("RegexSet_Match", amx.String("hello"), set, ids, count,
+                  MATCH_DEFAULT, 4) == 0);
+
+  // Each alternative of a top-level "|" contributes its literal
+  const PatternInfo info{"cats?|[Dd]ogs|a\\|b",
+                         std::regex_constants::ECMAScript, CharMode::kBytes};
+  EXPECT((info.GetAlternativeLiterals() ==
+          std::vector<std::string>{"cat", "ogs", "a|b"}));
+
+  const PatternInfo partial{"cats|\\d+", std::regex_constants::ECMAScript,
+                            CharMode::kBytes};
+  EXPECT(partial.GetAlternativeLiterals().empty());
+
+  EXPECT(amx.Call("RegexSet_Add", set, amx.String("cat|dog"), REGEX_DEFAULT,
+                  REGEX_ECMASCRIPT) == 3);
+  EXPECT(amx.Call("RegexSet_Add", set, amx.String("cats|\\d+"),
+                  REGEX_DEFAULT, REGEX_ECMASCRIPT) == 4);
+
+  EXPECT(amx.Call("RegexSet_Match", amx.String("hotdog"), set, ids, count,
+                  MATCH_DEFAULT, 4) == 1);
+  EXPECT(amx.At(count) == 1);
+  EXPECT(amx.At(ids) == 3);
+
+  EXPECT(amx.Call("RegexSet_Match", amx.String("42"), set, ids, count,
+                  MATCH_DEFAULT, 4) == 1);
+  EXPECT(amx.At(count) == 1);
+  EXPECT(amx.At(ids) == 4);
+}
+
+void TestRegexStream(FakeAmx &amx) {
+  const auto regex = amx.Call("Regex_New", amx.String("\\d+-\\d+"),
+                              REGEX_DEFAULT, REGEX_ECMASCRIPT);
+  const auto stream = amx.Call("RegexStream_New", regex, 8, MATCH_DEFAULT);
+
+  const auto match = amx.Ref();
+  const auto pos = amx.Ref();
+  const auto dest = amx.Array(16);
+  const auto length = amx.Ref();
+
+  // "ab 123-456 x 7-8", the first match is split across the chunks
+  EXPECT(amx.Call("RegexStream_Feed", stream, amx.String("ab 12")) == 0);
+  EXPECT(amx.Call("RegexStream_Feed", stream, amx.String("3-45")) == 0);
+  EXPECT(amx.Call("RegexStream_Next", stream, match, pos) == 0);
+
+  // Only the first match is followed by a whole window
+  EXPECT(amx.Call("RegexStream_Feed", stream, amx.String("6 x 7-8")) == 1);
+  EXPECT(amx.Call("RegexStream_Next", stream, match, pos) == 1);
+  EXPECT(amx.At(pos) == 3);
+  amx.Call("Match_GetGroup", amx.At(match), 0, dest, length, 16);
+  EXPECT(amx.GetString(dest) == "123-456");
+  amx.Call("Match_Free", match);
+
+  EXPECT(amx.Call("RegexStream_Finish", stream) == 1);
+  EXPECT(amx.Call("RegexStream_Next", stream, match, pos) == 1);
+  EXPECT(amx.At(pos) == 13);
+  amx.Call("Match_GetGroup", amx.At(match), 0, dest, length, 16);
+  EXPECT(amx.GetString(dest) == "7-8");
+  amx.Call("Match_Free", match);
+  EXPECT(amx.Call("RegexStream_Next", stream, match, pos) == 0);
+
+  EXPECT(amx.Call("RegexStream_Delete", amx.Ref(stream)) == 1);
+
+  // The buffer stays bounded however long the input is
+  RegexStream long_stream{
+      {std::make_shared<Regex>("\\bend\\b", std::regex_constants::ECMAScript,
+                               CharMode::kBytes, RegexEngine::kStd,
+                               Plugin::Instance().GetEngineLocales()),
+       MatchLimit{}},
+      16, std::regex_constants::match_default};
+
+  std::size_t count{};
+  for (int i{}; i < 1000; ++i) {
+    count += long_stream.Feed(i % 100 == 99 ? "the end " : "lorem ipsum ");
+
+    EXPECT(long_stream.GetBufferSize() <= 64);
+  }
+  count += long_stream.Finish();
+
+  EXPECT(count == 10);
+
+  std::size_t last_pos{};
+  while (const auto match = long_stream.Front()) {
+    last_pos = match->pos;
+
+    long_stream.Pop();
+  }
+  // 990 chunks of "lorem ipsum " and 9 of "the end " come before the last
+  EXPECT(last_pos == 990 * 12 + 9 * 8 + 4);
+}
+
+void TestScopedMatches(FakeAmx &amx) {
+  const auto regex = amx.Call("Regex_New", amx.String("a"), REGEX_DEFAULT,
+                              REGEX_ECMASCRIPT);
+
+  const auto live = amx.Ref();
+  const auto peak = amx.Ref();
+  const auto before = amx.Call("Match_GetCount", live, peak);
+
+  amx.Call("Match_SetScoped", 1);
+
+  const auto match = amx.Ref();
+  EXPECT(amx.Call("Regex_Match", amx.String("a"), regex, match,
+                  MATCH_DEFAULT) == 1);
+  EXPECT(amx.Call("Match_GetCount", live, peak) == before + 1);
+
+  FakeAmx::Tick();
+
+  EXPECT(amx.Call("Match_GetCount", live, peak) == before);
+  EXPECT(amx.Call("Match_GetGroupCount", amx.At(match)) == 0);
+
+  amx.Call("Match_SetScoped", 0);
+}
+
+void TestCache(FakeAmx &amx) {
+  const auto hits = amx.Ref();
+  const auto misses = amx.Ref();
+  const auto evictions = amx.Ref();
+
+  const auto pattern = amx.String("^cached\\d$");
+
+  amx.Call("Regex_CheckP", amx.String("cached1"), pattern, MATCH_DEFAULT,
+           REGEX_DEFAULT, REGEX_ECMASCRIPT);
+  amx.Call("Regex_GetCacheStats", hits, misses, evictions);
+
+  const auto hits_before = amx.At(hits);
+
+  EXPECT(amx.Call("Regex_CheckP", amx.String("cached2"), pattern,
+                  MATCH_DEFAULT, REGEX_DEFAULT, REGEX_ECMASCRIPT) == 1);
+  amx.Call("Regex_GetCacheStats", hits, misses, evictions);
+
+  EXPECT(amx.At(hits) == hits_before + 1);
+}
+
+void TestPatternBundle(FakeAmx &amx) {
+  auto &plugin = Plugin::Instance();
+
+  const auto errors = plugin.GetPatternBundle().Compile(
+      {
+          {"nickname", "[A-Z][a-z]+_[A-Z][a-z]+",
+           Script::GetRegexFlag(REGEX_DEFAULT, REGEX_ECMASCRIPT)},
+          {"yes", "y(es)?", Script::GetRegexFlag(REGEX_ICASE,
+                                                  REGEX_ECMASCRIPT)},
+          {"broken", "(", std::regex_constants::ECMAScript},
+      },
+      plugin.GetWorkerPool());
+
+  EXPECT(errors.size() == 1);
+  EXPECT(plugin.GetPatternBundle().Find("broken") == nullptr);
+
+  const auto yes = amx.Call("Regex_Get", amx.String("yes"));
+  EXPECT(yes != 0);
+  EXPECT(amx.Call("Regex_Check", amx.String("YES"), yes, MATCH_DEFAULT) == 1);
+
+  EXPECT(amx.Call("Regex_Get", amx.String("missing")) == 0);
+
+  // Regex_New gets the precompiled pattern from the cache
+  const auto hits = amx.Ref(), misses = amx.Ref(), evictions = amx.Ref();
+  amx.Call("Regex_GetCacheStats", hits, misses, evictions);
+
+  const auto misses_before = amx.At(misses);
+
+  amx.Call("Regex_New", amx.String("[A-Z][a-z]+_[A-Z][a-z]+"), REGEX_DEFAULT,
+           REGEX_ECMASCRIPT);
+  amx.Call("Regex_GetCacheStats", hits, misses, evictions);
+
+  EXPECT(amx.At(misses) == misses_before);
+}
+
+void TestSharedRegex(FakeAmx &amx) {
+  static FakeAmx filterscript;
+
+  const auto regex = amx.Call("Regex_New", amx.String("[0-9]+"),
+                              REGEX_DEFAULT, REGEX_ECMASCRIPT);
+
+  EXPECT(amx.Call("Regex_Share", regex, amx.String("digits")) == 1);
+
+  const auto imported =
+      filterscript.Call("Regex_Import", filterscript.String("digits"));
+  EXPECT(imported != 0);
+
+  // The import outlives the handle it was shared from
+  amx.Call("Regex_Delete", amx.Ref(regex));
+
+  EXPECT(filterscript.Call("Regex_Check", filterscript.String("42"),
+                           imported, MATCH_DEFAULT) == 1);
+
+  EXPECT(amx.Call("Regex_Unshare", amx.String("digits")) == 1);
+  EXPECT(amx.Call("Regex_Unshare", amx.String("digits")) == 0);
+  EXPECT(filterscript.Call("Regex_Import",
+                           filterscript.String("digits")) == 0);
+
+  // Readers on other threads while the main thread keeps replacing the table
+  auto &registry = Plugin::Instance().GetRegexRegistry();
+
+  const RegexRef shared{
+      std::make_shared<Regex>("a", std::regex_constants::ECMAScript,
+                              CharMode::kBytes, RegexEngine::kStd,
+                              Plugin::Instance().GetEngineLocales()),
+      MatchLimit{}};
+
+  std::atomic<bool> done{};
+  std::atomic<std::size_t> found{};
+  std::vector<std::thread> readers;
+
+  for (int i{}; i < 2; ++i) {
+    readers.emplace_back([&registry, &done, &found] {
+      while (!done) {
+        if (registry.Find("a")) {
+          ++found;
+        }
+      }
+    });
+  }
+
+  for (int i{}; i < 1000; ++i) {
+    registry.Add("a", shared);
+    registry.Add("b" + std::to_string(i % 10), shared);
+    registry.Remove("a");
+
+    FakeAmx::Tick();
+  }
+
+  done = true;
+
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  registry.Reclaim();
+
+  EXPECT(!registry.Find("a"));
+  EXPECT(registry.Size() == 10);
+}
+
+void TestMemoryLimits(FakeAmx &amx) {
+  auto &plugin = Plugin::Instance();
+
+  const auto limits = plugin.GetMemoryLimits();
+
+  const auto regexes = amx.Ref(), regex_bytes = amx.Ref();
+  const auto matches = amx.Ref(), match_bytes = amx.Ref();
+
+  const auto bytes_before = amx.Call("Regex_GetMemoryUsage", regexes,
+                                     regex_bytes, matches, match_bytes, 0, 0);
+  const auto regexes_before = amx.At(regexes);
+  const auto matches_before = amx.At(matches);
+
+  plugin.SetMemoryLimits(
+      {static_cast<std::size_t>(regexes_before) + 1,
+       static_cast<std::size_t>(matches_before) + 1, 0, 0});
+
+  const auto regex = amx.Call("Regex_New", amx.String("b+"), REGEX_DEFAULT,
+                              REGEX_ECMASCRIPT);
+  EXPECT(regex != 0);
+
+  // Refused before the pattern is compiled
+  const auto hits = amx.Ref(), misses = amx.Ref(), evictions = amx.Ref();
+  amx.Call("Regex_GetCacheStats", hits, misses, evictions);
+  const auto misses_before = amx.At(misses);
+
+  EXPECT(amx.Call("Regex_New", amx.String("c+"), REGEX_DEFAULT,
+                  REGEX_ECMASCRIPT) == 0);
+
+  amx.Call("Regex_GetCacheStats", hits, misses, evictions);
+  EXPECT(amx.At(misses) == misses_before);
+
+  EXPECT(amx.Call("Regex_GetMemoryUsage", regexes, regex_bytes, matches,
+                  match_bytes, 0, 0) > bytes_before);
+  EXPECT(amx.At(regexes) == regexes_before + 1);
+
+  // The match is refused, not mistaken for a miss
+  const auto first = amx.Ref(), second = amx.Ref();
+  EXPECT(amx.Call("Regex_Match", amx.String("bb"), regex, first,
+                  MATCH_DEFAULT) == 1);
+  EXPECT(amx.Call("Regex_Match", amx.String("bb"), regex, second,
+                  MATCH_DEFAULT) == 0);
+  EXPECT(amx.Call("Regex_GetLastError") == REGEX_ERROR_LIMIT);
+  amx.Call("Match_Free", first);
+  EXPECT(amx.Call("Regex_Match", amx.String("bb"), regex, second,
+                  MATCH_DEFAULT) == 1);
+  amx.Call("Match_Free", second);
+
+  // A byte cap applies to the whole script
+  plugin.SetMemoryLimits({0, 0, static_cast<std::size_t>(bytes_before), 0});
+  EXPECT(amx.Call("Regex_New", amx.String("d+"), REGEX_DEFAULT,
+                  REGEX_ECMASCRIPT) == 0);
+
+  plugin.SetMemoryLimits(limits);
+
+  const auto usage = [&] {
+    return amx.Call("Regex_GetMemoryUsage", regexes, regex_bytes, matches,
+                    match_bytes, 0, 0);
+  };
+
+  // A set counts as a regex and so does every member
+  const auto set_before = usage();
+  const auto set = amx.Call("RegexSet_New");
+  EXPECT(amx.Call("RegexSet_Add", set, amx.String("e+"), REGEX_DEFAULT,
+                  REGEX_ECMASCRIPT) == 0);
+  EXPECT(usage() > set_before);
+  EXPECT(amx.At(regexes) == regexes_before + 3);
+
+  plugin.SetMemoryLimits(
+      {static_cast<std::size_t>(regexes_before) + 3, 0, 0, 0});
+  EXPECT(amx.Call("RegexSet_Add", set, amx.String("f+"), REGEX_DEFAULT,
+                  REGEX_ECMASCRIPT) == -1);
+  plugin.SetMemoryLimits(limits);
+
+  amx.Call("RegexSet_Delete", amx.Ref(set));
+  EXPECT(usage() == set_before);
+
+  // A stream counts the text and the matches it holds, and refuses chunks
+  // once they are over a limit
+  const auto stream_before = usage();
+  const auto stream = amx.Call("RegexStream_New", regex, 256, MATCH_DEFAULT);
+  const auto stream_bytes = usage();
+  EXPECT(stream_bytes > stream_before);
+  EXPECT(amx.Call("RegexStream_Feed", stream, amx.String("bb bb bb")) == 1);
+  const auto fed_bytes = usage();
+  EXPECT(fed_bytes > stream_bytes);
+
+  plugin.SetMemoryLimits({0, 0, static_cast<std::size_t>(fed_bytes), 0});
+  EXPECT(amx.Call("RegexStream_Feed", stream, amx.String("bb")) == 0);
+  EXPECT(amx.Call("Regex_GetLastError") == REGEX_ERROR_LIMIT);
+  plugin.SetMemoryLimits(limits);
+
+  const auto pos = amx.Ref();
+  EXPECT(amx.Call("RegexStream_Next", stream, first, pos) == 1);
+  amx.Call("Match_Free", first);
+  EXPECT(usage() < fed_bytes);
+
+  amx.Call("RegexStream_Delete", amx.Ref(stream));
+  EXPECT(usage() == stream_before);
+
+  amx.Call("Regex_Delete", amx.Ref(regex));
+
+  EXPECT(amx.Call("Regex_GetMemoryUsage", regexes, regex_bytes, matches,
+                  match_bytes, 0, 0) == bytes_before);
+  EXPECT(amx.At(matches) == matches_before);
+
+  EXPECT(amx.Call("Regex_GetMemoryUsage", regexes, regex_bytes, matches,
+                  match_bytes, 1, 0) > bytes_before);
+  EXPECT(amx.Call("Regex_GetMemoryUsage", regexes, regex_bytes, matches,
+                  match_bytes, 0, 1) >= bytes_before);
+}
+
+void TestLimit(FakeAmx &amx) {
+  const auto regex = amx.Call("Regex_New", amx.String("(a+)+b"),
+                              REGEX_DEFAULT, REGEX_ECMASCRIPT);
+
+  EXPECT(amx.Call("Regex_SetLimit", regex, 0, 10000) == 1);
+
+  // The "b" keeps the subject past the literal prefilter
+  const auto str = amx.String(std::string(32, 'a') + "!b");
+  EXPECT(amx.Call("Regex_Check", str, regex, MATCH_DEFAULT) == 0);
+  EXPECT(amx.Call("Regex_GetLastError") == REGEX_ERROR_TIMEOUT);
+  EXPECT(amx.Call("Regex_GetTimeoutCount", regex) == 1);
+
+  EXPECT(amx.Call("Regex_Check", amx.String("aab"), regex, MATCH_DEFAULT) ==
+         1);
+  EXPECT(amx.Call("Regex_GetLastError") == REGEX_ERROR_NONE);
+
+  // A timed out row counts as a miss
+  const auto strings = amx.StringArray({std::string(32, 'a') + "!b", "aab"});
+  const auto results = amx.Array(2);
+  EXPECT(amx.Call("Regex_CheckMany", strings, 2, regex, results,
+                  MATCH_DEFAULT, 2, 2) == 1);
+  EXPECT(amx.At(results) == 0);
+  EXPECT(amx.At(results + 1) == 1);
+  EXPECT(amx.Call("Regex_GetLastError") == REGEX_ERROR_TIMEOUT);
+
+  // Regex_New hands out the same cached pattern, the limit stays with the
+  // handle it was set on while the timeouts are counted for the pattern
+  const auto other = amx.Call("Regex_New", amx.String("(a+)+b"),
+                              REGEX_DEFAULT, REGEX_ECMASCRIPT);
+  const auto short_str = amx.String(std::string(14, 'a') + "!b");
+  EXPECT(amx.Call("Regex_Check", short_str, regex, MATCH_DEFAULT) == 0);
+  EXPECT(amx.Call("Regex_GetLastError") == REGEX_ERROR_TIMEOUT);
+  EXPECT(amx.Call("Regex_Check", short_str, other, MATCH_DEFAULT) == 0);
+  EXPECT(amx.Call("Regex_GetLastError") == REGEX_ERROR_NONE);
+  EXPECT(amx.Call("Regex_GetTimeoutCount", other) == 3);
+
+  // Streams and shared regexes run under the limit of the handle they were
+  // made from
+  const auto stream = amx.Call("RegexStream_New", regex, 256, MATCH_DEFAULT);
+  EXPECT(amx.Call("RegexStream_Feed", stream, str) == 0);
+  EXPECT(amx.Call("RegexStream_Finish", stream) == 0);
+  EXPECT(amx.Call("Regex_GetLastError") == REGEX_ERROR_TIMEOUT);
+  amx.Call("RegexStream_Delete", amx.Ref(stream));
+
+  EXPECT(amx.Call("Regex_Share", regex, amx.String("limited")) == 1);
+  const auto imported = amx.Call("Regex_Import", amx.String("limited"));
+  EXPECT(amx.Call("Regex_Check", str, imported, MATCH_DEFAULT) == 0);
+  EXPECT(amx.Call("Regex_GetLastError") == REGEX_ERROR_TIMEOUT);
+  amx.Call("Regex_Unshare", amx.String("limited"));
+
+  amx.Call("Regex_Delete", amx.Ref(imported));
+  amx.Call("Regex_Delete", amx.Ref(other));
+  amx.Call("Regex_Delete", amx.Ref(regex));
+}
+
+void TestAsync(FakeAmx &amx) {
+  cell found_pos = -2, found_match{}, found_error{};
+  std::string replaced;
+
+  amx.AddPublic("OnSearchDone", [&](const std::vector<cell> &args) {
+    found_match = args.at(1);
+    found_pos = args.at(2);
+    found_error = amx.Call("Regex_GetLastError");
+
+    return 1;
+  });
+
+  amx.AddPublic("OnReplaceDone",
+                [&amx, &replaced](const std::vector<cell> &args) {
+                  replaced = amx.GetString(args.at(1));
+
+                  return 1;
+                });
+
+  const auto regex = amx.Call("Regex_New", amx.String("b+"), REGEX_DEFAULT,
+                              REGEX_ECMASCRIPT);
+
+  EXPECT(amx.Call("Regex_SearchAsync", amx.String("aabbb"), regex,
+                  amx.String("OnSearchDone"), 7, 0, MATCH_DEFAULT) == 1);
+  EXPECT(amx.Call("Regex_ReplaceAsync", amx.String("abba"), regex,
+                  amx.String("-"), amx.String("OnReplaceDone"), 0,
+                  MATCH_DEFAULT) == 1);
+
+  for (int i{}; i < 1000 && (found_pos == -2 || replaced.empty()); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds{1});
+
+    FakeAmx::Tick();
+  }
+
+  EXPECT(found_pos == 2);
+  EXPECT(replaced == "a-a");
+
+  const auto wait_search = [&found_pos] {
+    for (int i{}; i < 1000 && found_pos == -2; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds{1});
+
+      FakeAmx::Tick();
+    }
+  };
+
+  // MATCH_RELATIVE_POS counts from startpos as in Regex_Search
+  found_pos = -2;
+  EXPECT(amx.Call("Regex_SearchAsync", amx.String("aabbb"), regex,
+                  amx.String("OnSearchDone"), 7, 1, MATCH_RELATIVE_POS) == 1);
+  wait_search();
+  EXPECT(found_pos == 1);
+
+  // A match the script cannot hold is reported as none
+  const auto regexes = amx.Ref(), regex_bytes = amx.Ref();
+  const auto matches = amx.Ref(), match_bytes = amx.Ref();
+
+  auto &plugin = Plugin::Instance();
+  const auto limits = plugin.GetMemoryLimits();
+
+  plugin.SetMemoryLimits(
+      {0, 0,
+       static_cast<std::size_t>(amx.Call("Regex_GetMemoryUsage", regexes,
+                                         regex_bytes, matches, match_bytes, 0,
+                                         0)),
+       0});
+
+  found_pos = -2;
+  EXPECT(amx.Call("Regex_SearchAsync", amx.String("aabbb"), regex,
+                  amx.String("OnSearchDone"), 7, 0, MATCH_DEFAULT) == 1);
+  wait_search();
+  EXPECT(found_pos == -1);
+  EXPECT(found_match == 0);
+  EXPECT(found_error == REGEX_ERROR_LIMIT);
+
+  plugin.SetMemoryLimits(limits);
+
+  // A script unloaded before its job completes is skipped, and what it held
+  // no longer counts for the plugin
+
+  const auto bytes_before = amx.Call("Regex_GetMemoryUsage", regexes,
+                                     regex_bytes, matches, match_bytes, 0, 1);
+
+  bool called{};
+
+  {
+    FakeAmx filterscript;
+
+    filterscript.AddPublic("OnSearchDone",
+                           [&called](const std::vector<cell> &) {
+                             called = true;
+
+                             return 1;
+                           });
+
+    const auto local = filterscript.Call("Regex_New",
+                                         filterscript.String("b+"),
+                                         REGEX_DEFAULT, REGEX_ECMASCRIPT);
+
+    EXPECT(filterscript.Call("Regex_SearchAsync", filterscript.String("abb"),
+                             local, filterscript.String("OnSearchDone"), 0, 0,
+                             MATCH_DEFAULT) == 1);
+  }
+
+  for (int i{}; i < 50; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds{1});
+
+    FakeAmx::Tick();
+  }
+
+  EXPECT(!called);
+  EXPECT(amx.Call("Regex_GetMemoryUsage", regexes, regex_bytes, matches,
+                  match_bytes, 0, 1) == bytes_before);
+}
+
+}  // namespace
+
+int main() {
+  const std::vector<std::pair<const char *, void (*)(FakeAmx &)>> tests{
+      {"Check", &TestCheck},
+      {"MatchGroups", &TestMatchGroups},
+      {"NamedGroups", &TestNamedGroups},
+      {"Search", &TestSearch},
+      {"Replace", &TestReplace},
+      {"Allocations", &TestAllocations},
+      {"CharModes", &TestCharModes},
+      {"Engines", &TestEngines},
+      {"Batch", &TestBatch},
+      {"SearchAll", &TestSearchAll},
+      {"LiteralPatterns", &TestLiteralPatterns},
+      {"RegexSet", &TestRegexSet},
+      {"RegexStream", &TestRegexStream},
+      {"ScopedMatches", &TestScopedMatches},
+      {"Cache", &TestCache},
+      {"PatternBundle", &TestPatternBundle},
+      {"SharedRegex", &TestSharedRegex},
+      {"MemoryLimits", &TestMemoryLimits},
+      {"Limit", &TestLimit},
+      {"Async", &TestAsync},
+  };
+
+  static FakeAmx amx;
+
+  for (const auto &[name, test] : tests) {
+    const auto mark = amx.GetHeapMark();
+    const auto failures_before = failures;
+
+    test(amx);
+
+    amx.Release(mark);
+
+    std::printf("[%s] %s\n", failures == failures_before ? "PASS" : "FAIL",
+                name);
+  }
+
+  FakeAmx::Unload();
+
+  return failures ? 1 : 0;
+}